@@ -0,0 +1,78 @@
+#include "alloc_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::uint64_t> AllocCount(0);
+static thread_local std::uint64_t ThreadAllocCount = 0; // Constant-initialized, so reading it never allocates
+
+std::uint64_t alloc_count()
+{
+	return AllocCount.load(std::memory_order_relaxed);
+}
+
+std::uint64_t thread_alloc_count()
+{
+	return ThreadAllocCount;
+}
+
+static void count_alloc()
+{
+	AllocCount.fetch_add(1, std::memory_order_relaxed);
+	ThreadAllocCount++;
+}
+
+static void* counted_alloc(std::size_t size)
+{
+	count_alloc();
+
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new(std::size_t size)
+{
+	return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return counted_alloc(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	count_alloc();
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	count_alloc();
+	return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+//=================================================================================================
+// ALLOCATION TRACKER
+//
+// alloc_tracker.cpp replaces the global operator new/delete and counts every heap allocation.
+// Steady-state frames are expected to allocate nothing; wrap a block in an AllocationGuard to
+// assert that in debug builds. The guard compares the calling thread's own count, so a guard on
+// the GLUT thread and one on the simulation thread do not see each other's allocations.
+//=================================================================================================
+
+// Number of operator new calls since the program started
+std::uint64_t alloc_count();
+
+// Number of operator new calls made by the calling thread
+std::uint64_t thread_alloc_count();
+
+class AllocationGuard
+{
+public:
+	AllocationGuard() : start(thread_alloc_count()) {}
+
+	~AllocationGuard()
+	{
+		assert(thread_alloc_count() == start && "heap allocation inside a steady-state frame");
+	}
+
+	std::uint64_t allocations() const { return thread_alloc_count() - start; }
+
+private:
+	std::uint64_t start;
+};
@@ -0,0 +1,516 @@
+#include "atlas.h"
+#include "gl_ext.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static const char CACHE_MAGIC[4] = { 'A', 'T', 'L', 'S' };
+static const std::uint32_t CACHE_VERSION = 1;
+static const int PADDING = 1; // Empty pixels between sprites so filtering never picks up a neighbour
+
+//=================================================================================================
+// HELPERS
+//=================================================================================================
+
+static void put_u32(std::vector<unsigned char>& out, std::uint32_t v)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		out.push_back(static_cast<unsigned char>(v >> (i * 8)));
+	}
+}
+
+static std::uint32_t get_u32(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+static std::uint64_t fnv1a(std::uint64_t hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static int next_power_of_two(int v)
+{
+	int p = 1;
+	while (p < v)
+	{
+		p <<= 1;
+	}
+	return p;
+}
+
+static std::string stem_of(const std::string& file)
+{
+	size_t slash = file.find_last_of("/\\");
+	std::string name = slash == std::string::npos ? file : file.substr(slash + 1);
+	return name.substr(0, name.find_last_of('.'));
+}
+
+//=================================================================================================
+// SKYLINE PACKER
+//=================================================================================================
+
+struct SkylineNode
+{
+	int x, y, width;
+};
+
+// Lowest y at which a w-wide rectangle fits with its left edge on node index, -1 if it runs off
+// the right side
+static int skyline_fit(const std::vector<SkylineNode>& skyline, size_t index, int w, int page_width)
+{
+	int x = skyline[index].x;
+	if (x + w > page_width)
+	{
+		return -1;
+	}
+
+	int y = 0;
+	int remaining = w;
+	for (size_t i = index; remaining > 0; ++i)
+	{
+		y = std::max(y, skyline[i].y);
+		remaining -= skyline[i].width;
+	}
+	return y;
+}
+
+// Places a w x h rectangle at the lowest (then leftmost) spot on the skyline and raises it
+static bool skyline_insert(std::vector<SkylineNode>& skyline, int w, int h, int page_width, int page_height, int& out_x, int& out_y)
+{
+	int best_y = page_height;
+	int best_x = 0;
+	size_t best = skyline.size();
+	for (size_t i = 0; i < skyline.size(); ++i)
+	{
+		int y = skyline_fit(skyline, i, w, page_width);
+		if (y >= 0 && y + h <= page_height && y < best_y)
+		{
+			best_y = y;
+			best_x = skyline[i].x;
+			best = i;
+		}
+	}
+	if (best == skyline.size())
+	{
+		return false;
+	}
+
+	// The new node covers [best_x, best_x + w); trim or drop the nodes it now shadows
+	SkylineNode node = { best_x, best_y + h, w };
+	skyline.insert(skyline.begin() + best, node);
+	for (size_t i = best + 1; i < skyline.size();)
+	{
+		int shadow_end = node.x + node.width;
+		if (skyline[i].x >= shadow_end)
+		{
+			break;
+		}
+
+		int shrink = shadow_end - skyline[i].x;
+		skyline[i].x += shrink;
+		skyline[i].width -= shrink;
+		if (skyline[i].width <= 0)
+		{
+			skyline.erase(skyline.begin() + i);
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	// Merge neighbours at the same height to keep the skyline short
+	for (size_t i = 0; i + 1 < skyline.size();)
+	{
+		if (skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	out_x = best_x;
+	out_y = best_y;
+	return true;
+}
+
+//=================================================================================================
+// TEXTURE ATLAS
+//=================================================================================================
+
+bool TextureAtlas::build(const std::string& manifest_path, const std::string& cache_path, int max_size)
+{
+	std::vector<std::string> files;
+	if (!read_manifest(manifest_path, files))
+	{
+		std::cout << "Could not read sprite manifest " << manifest_path << "\n";
+		return false;
+	}
+
+	// The cache key covers every byte that could change the result
+	std::vector<std::vector<unsigned char>> contents(files.size());
+	std::uint64_t hash = 14695981039346656037ull;
+	hash = fnv1a(hash, &CACHE_VERSION, sizeof(CACHE_VERSION));
+	hash = fnv1a(hash, &max_size, sizeof(max_size));
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		if (!read_file(files[i], contents[i]))
+		{
+			std::cout << "Could not read sprite " << files[i] << "\n";
+			return false;
+		}
+		hash = fnv1a(hash, files[i].data(), files[i].size() + 1);
+		hash = fnv1a(hash, contents[i].data(), contents[i].size());
+	}
+
+	mapped_pixels = nullptr;
+	if (!cache_path.empty() && load_cache(cache_path, hash))
+	{
+		cache_hit = true;
+		return true;
+	}
+	cache_hit = false;
+
+	std::vector<Image> images(files.size());
+	std::vector<std::string> names(files.size());
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		if (!decode_ppm(contents[i].data(), contents[i].size(), images[i]))
+		{
+			std::cout << "Sprite " << files[i] << " is not an 8-bit PPM\n";
+			return false;
+		}
+		names[i] = stem_of(files[i]);
+	}
+
+	if (!pack(images, names, max_size))
+	{
+		std::cout << "Sprites do not fit in a " << max_size << "x" << max_size << " atlas\n";
+		return false;
+	}
+
+	if (!cache_path.empty() && !save_cache(cache_path, hash))
+	{
+		std::cout << "Could not write atlas cache " << cache_path << "\n";
+	}
+	return true;
+}
+
+bool TextureAtlas::pack(const std::vector<Image>& images, const std::vector<std::string>& names, int max_size)
+{
+	// Tallest first packs tightest on a skyline
+	std::vector<size_t> order(images.size());
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&images](size_t a, size_t b)
+	{
+		if (images[a].height != images[b].height)
+		{
+			return images[a].height > images[b].height;
+		}
+		return images[a].width > images[b].width;
+	});
+
+	// Smallest power-of-two page that holds everything; GL 1.1 cannot use anything else
+	for (int size = 16; size <= max_size; size *= 2)
+	{
+		std::vector<SkylineNode> skyline(1, SkylineNode{ 0, 0, size });
+		std::vector<AtlasRegion> placed(images.size());
+
+		bool fits = true;
+		int used_height = 0;
+		for (size_t i : order)
+		{
+			int x, y;
+			if (!skyline_insert(skyline, images[i].width + PADDING, images[i].height + PADDING, size, size, x, y))
+			{
+				fits = false;
+				break;
+			}
+			placed[i] = { names[i], x, y, images[i].width, images[i].height, {} };
+			used_height = std::max(used_height, y + images[i].height + PADDING);
+		}
+		if (!fits)
+		{
+			continue;
+		}
+
+		page_width = size;
+		page_height = next_power_of_two(used_height);
+		pixels.assign(static_cast<size_t>(page_width) * page_height * 4, 0);
+
+		for (size_t i = 0; i < images.size(); ++i)
+		{
+			AtlasRegion& region = placed[i];
+			for (int row = 0; row < region.height; ++row)
+			{
+				std::memcpy(&pixels[(static_cast<size_t>(region.y + row) * page_width + region.x) * 4],
+					&images[i].rgba[static_cast<size_t>(row) * region.width * 4], region.width * 4);
+			}
+			region.uv.u0 = static_cast<float>(region.x) / page_width;
+			region.uv.v0 = static_cast<float>(region.y) / page_height;
+			region.uv.u1 = static_cast<float>(region.x + region.width) / page_width;
+			region.uv.v1 = static_cast<float>(region.y + region.height) / page_height;
+		}
+
+		regions.swap(placed);
+		return true;
+	}
+	return false;
+}
+
+bool TextureAtlas::load_cache(const std::string& path, std::uint64_t hash)
+{
+	std::vector<unsigned char> data;
+	if (!read_file(path, data) || data.size() < 28 || std::memcmp(data.data(), CACHE_MAGIC, 4) != 0
+		|| get_u32(&data[4]) != CACHE_VERSION
+		|| (get_u32(&data[8]) | (static_cast<std::uint64_t>(get_u32(&data[12])) << 32)) != hash)
+	{
+		return false;
+	}
+
+	// Everything below comes from the file, so it is checked against the bytes actually there
+	// before it sizes or indexes anything
+	std::uint32_t file_width = get_u32(&data[16]);
+	std::uint32_t file_height = get_u32(&data[20]);
+	std::uint32_t count = get_u32(&data[24]);
+	size_t at = 28;
+	if (file_width == 0 || file_height == 0 || file_width > INT_MAX || file_height > INT_MAX
+		|| static_cast<std::uint64_t>(file_width) * file_height > (data.size() - at) / 4)
+	{
+		return false;
+	}
+	int cached_width = static_cast<int>(file_width);
+	int cached_height = static_cast<int>(file_height);
+
+	// Each region takes at least a length and four coordinates
+	if (count > (data.size() - at) / 20)
+	{
+		return false;
+	}
+	std::vector<AtlasRegion> cached(count);
+	for (AtlasRegion& region : cached)
+	{
+		if (data.size() - at < 4)
+		{
+			return false;
+		}
+		size_t name_length = get_u32(&data[at]);
+		at += 4;
+		if (data.size() - at < 16 || data.size() - at - 16 < name_length)
+		{
+			return false;
+		}
+		region.name.assign(reinterpret_cast<const char*>(&data[at]), name_length);
+		at += name_length;
+		std::uint32_t x = get_u32(&data[at]);
+		std::uint32_t y = get_u32(&data[at + 4]);
+		std::uint32_t width = get_u32(&data[at + 8]);
+		std::uint32_t height = get_u32(&data[at + 12]);
+		at += 16;
+		if (static_cast<std::uint64_t>(x) + width > file_width || static_cast<std::uint64_t>(y) + height > file_height)
+		{
+			return false;
+		}
+		region.x = static_cast<int>(x);
+		region.y = static_cast<int>(y);
+		region.width = static_cast<int>(width);
+		region.height = static_cast<int>(height);
+
+		region.uv.u0 = static_cast<float>(region.x) / cached_width;
+		region.uv.v0 = static_cast<float>(region.y) / cached_height;
+		region.uv.u1 = static_cast<float>(region.x + region.width) / cached_width;
+		region.uv.v1 = static_cast<float>(region.y + region.height) / cached_height;
+	}
+
+	size_t pixel_bytes = static_cast<size_t>(cached_width) * cached_height * 4;
+	if (data.size() - at != pixel_bytes)
+	{
+		return false;
+	}
+
+	pixels.assign(data.begin() + at, data.end());
+	regions.swap(cached);
+	page_width = cached_width;
+	page_height = cached_height;
+	return true;
+}
+
+bool TextureAtlas::save_cache(const std::string& path, std::uint64_t hash) const
+{
+	std::vector<unsigned char> out;
+	out.reserve(28 + regions.size() * 32 + pixels.size());
+
+	out.insert(out.end(), CACHE_MAGIC, CACHE_MAGIC + 4);
+	put_u32(out, CACHE_VERSION);
+	put_u32(out, static_cast<std::uint32_t>(hash));
+	put_u32(out, static_cast<std::uint32_t>(hash >> 32));
+	put_u32(out, static_cast<std::uint32_t>(page_width));
+	put_u32(out, static_cast<std::uint32_t>(page_height));
+	put_u32(out, static_cast<std::uint32_t>(regions.size()));
+
+	for (const AtlasRegion& region : regions)
+	{
+		put_u32(out, static_cast<std::uint32_t>(region.name.size()));
+		out.insert(out.end(), region.name.begin(), region.name.end());
+		put_u32(out, static_cast<std::uint32_t>(region.x));
+		put_u32(out, static_cast<std::uint32_t>(region.y));
+		put_u32(out, static_cast<std::uint32_t>(region.width));
+		put_u32(out, static_cast<std::uint32_t>(region.height));
+	}
+	out.insert(out.end(), pixels.begin(), pixels.end());
+
+	FILE* file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+	return std::fclose(file) == 0 && ok;
+}
+
+bool TextureAtlas::load_bundle(const AssetBundle& bundle)
+{
+	const BundleEntry* texture_entry = bundle.find("atlas", BUNDLE_TEXTURE);
+	const BundleEntry* regions_entry = bundle.find("atlas", BUNDLE_ATLAS_REGIONS);
+	if (!texture_entry || !regions_entry || texture_entry->size < sizeof(BundleTexture)
+		|| regions_entry->size % sizeof(BundleRegion) != 0)
+	{
+		return false;
+	}
+
+	// Checked like the cache: nothing from the file sizes or indexes anything before it is known to
+	// fit, and on failure the atlas is left alone so the caller can pack the loose files instead
+	const BundleTexture* texture = reinterpret_cast<const BundleTexture*>(bundle.data(*texture_entry));
+	const std::uint32_t file_width = texture->width;
+	const std::uint32_t file_height = texture->height;
+	if (file_width == 0 || file_height == 0 || file_width > INT_MAX || file_height > INT_MAX
+		|| static_cast<std::uint64_t>(file_width) * file_height > (texture_entry->size - sizeof(BundleTexture)) / 4
+		|| texture_entry->size - sizeof(BundleTexture) != static_cast<size_t>(file_width) * file_height * 4)
+	{
+		return false;
+	}
+	const int bundle_width = static_cast<int>(file_width);
+	const int bundle_height = static_cast<int>(file_height);
+
+	const BundleRegion* packed = reinterpret_cast<const BundleRegion*>(bundle.data(*regions_entry));
+	size_t count = regions_entry->size / sizeof(BundleRegion);
+	std::vector<AtlasRegion> loaded(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (static_cast<std::uint64_t>(packed[i].x) + packed[i].width > file_width
+			|| static_cast<std::uint64_t>(packed[i].y) + packed[i].height > file_height)
+		{
+			return false;
+		}
+
+		AtlasRegion& region = loaded[i];
+		const char* end = static_cast<const char*>(std::memchr(packed[i].name, 0, sizeof(packed[i].name)));
+		region.name.assign(packed[i].name, end ? end : packed[i].name + sizeof(packed[i].name));
+		region.x = static_cast<int>(packed[i].x);
+		region.y = static_cast<int>(packed[i].y);
+		region.width = static_cast<int>(packed[i].width);
+		region.height = static_cast<int>(packed[i].height);
+		region.uv.u0 = static_cast<float>(region.x) / bundle_width;
+		region.uv.v0 = static_cast<float>(region.y) / bundle_height;
+		region.uv.u1 = static_cast<float>(region.x + region.width) / bundle_width;
+		region.uv.v1 = static_cast<float>(region.y + region.height) / bundle_height;
+	}
+
+	regions.swap(loaded);
+	page_width = bundle_width;
+	page_height = bundle_height;
+	pixels.clear();
+	mapped_pixels = bundle.data(*texture_entry) + sizeof(BundleTexture);
+	return true;
+}
+
+void TextureAtlas::to_bundle(std::vector<BundleInput>& out) const
+{
+	BundleInput texture;
+	texture.name = "atlas";
+	texture.type = BUNDLE_TEXTURE;
+	BundleTexture header = { static_cast<std::uint32_t>(page_width), static_cast<std::uint32_t>(page_height) };
+	const unsigned char* header_bytes = reinterpret_cast<const unsigned char*>(&header);
+	texture.bytes.assign(header_bytes, header_bytes + sizeof(header));
+	texture.bytes.insert(texture.bytes.end(), pixels.begin(), pixels.end());
+	out.push_back(texture);
+
+	BundleInput packed;
+	packed.name = "atlas";
+	packed.type = BUNDLE_ATLAS_REGIONS;
+	for (const AtlasRegion& region : regions)
+	{
+		BundleRegion entry;
+		std::memset(&entry, 0, sizeof(entry));
+		std::strncpy(entry.name, region.name.c_str(), sizeof(entry.name) - 1);
+		entry.x = static_cast<std::uint32_t>(region.x);
+		entry.y = static_cast<std::uint32_t>(region.y);
+		entry.width = static_cast<std::uint32_t>(region.width);
+		entry.height = static_cast<std::uint32_t>(region.height);
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&entry);
+		packed.bytes.insert(packed.bytes.end(), bytes, bytes + sizeof(entry));
+	}
+	out.push_back(packed);
+}
+
+GLuint TextureAtlas::upload()
+{
+	const unsigned char* source = mapped_pixels ? mapped_pixels : pixels.data();
+	if (page_width == 0 || !source)
+	{
+		return 0;
+	}
+
+	glGenTextures(1, &texture_id);
+	glBindTexture(GL_TEXTURE_2D, texture_id);
+
+	// Pixel art: no filtering, and rows are tightly packed
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page_width, page_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, source);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture_id;
+}
+
+void TextureAtlas::shutdown()
+{
+	if (texture_id != 0)
+	{
+		glDeleteTextures(1, &texture_id);
+		texture_id = 0;
+	}
+}
+
+const AtlasRegion* TextureAtlas::find(const char* name) const
+{
+	for (const AtlasRegion& region : regions)
+	{
+		if (region.name == name)
+		{
+			return &region;
+		}
+	}
+	return nullptr;
+}
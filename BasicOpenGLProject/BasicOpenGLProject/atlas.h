@@ -0,0 +1,68 @@
+#pragma once
+
+#include "bundle.h"
+#include "image.h"
+#include "sprite_batch.h"
+
+#include <GL/freeglut.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//=================================================================================================
+// TEXTURE ATLAS
+//
+// Packs every sprite listed in a manifest into one texture at startup, so all textured sprites
+// share a material and never force a texture bind between draws. Packing is a skyline bottom-left
+// fit; the result is cached on disk keyed by a hash of the sprite files, and later launches with
+// unchanged sprites load the cache instead of decoding and packing again. A packed atlas can also
+// be stored in and used straight from an asset bundle.
+//=================================================================================================
+
+struct AtlasRegion
+{
+	std::string name; // File name without the extension
+	int x, y, width, height; // Pixels in the atlas
+	UvRect uv;
+};
+
+class TextureAtlas
+{
+public:
+	// Loads the manifest (one image per line, relative to the manifest, # comments) and packs the
+	// images into a power-of-two page no larger than max_size. False if an image is missing or
+	// broken, or if they do not fit.
+	bool build(const std::string& manifest_path, const std::string& cache_path, int max_size = 1024);
+
+	// Uses the "atlas" texture and regions of a bundle. The pixels are not copied, so the bundle
+	// has to stay open until upload.
+	bool load_bundle(const AssetBundle& bundle);
+
+	// Appends the packed texture and regions as bundle assets named "atlas"
+	void to_bundle(std::vector<BundleInput>& out) const;
+
+	// Creates the GL texture from the packed pixels, needs a current context
+	GLuint upload();
+	void shutdown();
+
+	// nullptr if no sprite of that name was packed
+	const AtlasRegion* find(const char* name) const;
+
+	GLuint texture() const { return texture_id; }
+	int width() const { return page_width; }
+	int height() const { return page_height; }
+	bool from_cache() const { return cache_hit; }
+
+private:
+	bool pack(const std::vector<Image>& images, const std::vector<std::string>& names, int max_size);
+	bool load_cache(const std::string& path, std::uint64_t hash);
+	bool save_cache(const std::string& path, std::uint64_t hash) const;
+
+	std::vector<AtlasRegion> regions;
+	std::vector<unsigned char> pixels; // RGBA, page_width * page_height
+	const unsigned char* mapped_pixels = nullptr; // Inside a bundle, used instead of pixels
+	int page_width = 0;
+	int page_height = 0;
+	bool cache_hit = false;
+	GLuint texture_id = 0;
+};
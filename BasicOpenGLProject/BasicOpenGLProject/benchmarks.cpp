@@ -0,0 +1,455 @@
+#include "benchmarks.h"
+#include "collision_kernel.h"
+#include "entities.h"
+#include "entity_sprites.h"
+#include "game.h"
+#include "game_loop.h"
+#include "jobs.h"
+#include "particles.h"
+#include "snapshot.h"
+#include "spatial_grid.h"
+#include "stress_scene.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Fills a store with n entities scattered over the play field with random velocities
+static void populate(EntityStore& entities, size_t n, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> pos(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> vel(-0.5f, 0.5f);
+
+	entities.clear();
+	entities.reserve(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		entities.create(KIND_BULLET, pos(rng), pos(rng), vel(rng), vel(rng), 0.01f, 0.01f);
+	}
+}
+
+void bench_entities()
+{
+	const size_t counts[] = { 1000, 10000, 100000 };
+
+	std::printf("EntityStore::update\n");
+	for (size_t n : counts)
+	{
+		EntityStore entities;
+		populate(entities, n, 1234);
+
+		// Aim for roughly the same amount of work at every size
+		const int iterations = static_cast<int>(20000000 / n);
+
+		entities.update(TICK_DT); // warm up caches
+
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < iterations; ++i)
+		{
+			entities.update(TICK_DT);
+		}
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		double ns_per_entity = seconds * 1e9 / (static_cast<double>(n) * iterations);
+		std::printf("  %7zu entities: %6.3f ns/entity (%d updates, x=%.3f)\n", n, ns_per_entity, iterations, entities.pos_x[0]);
+	}
+}
+
+struct Boxes
+{
+	std::vector<float> x, y, hw, hh;
+};
+
+static Boxes random_boxes(size_t n, float half_w, float half_h, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> pos(-1.0f, 1.0f);
+
+	Boxes boxes;
+	for (size_t i = 0; i < n; ++i)
+	{
+		boxes.x.push_back(pos(rng));
+		boxes.y.push_back(pos(rng));
+		boxes.hw.push_back(half_w);
+		boxes.hh.push_back(half_h);
+	}
+	return boxes;
+}
+
+static bool overlaps(const Boxes& a, size_t i, const Boxes& b, size_t j)
+{
+	return a.x[i] - a.hw[i] <= b.x[j] + b.hw[j] && a.x[i] + a.hw[i] >= b.x[j] - b.hw[j]
+		&& a.y[i] - a.hh[i] <= b.y[j] + b.hh[j] && a.y[i] + a.hh[i] >= b.y[j] - b.hh[j];
+}
+
+static double ms_since(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool bench_collision()
+{
+	const size_t bullet_count = 10000;
+	const size_t enemy_count = 1000;
+	const int rounds = 20;
+
+	Boxes bullets = random_boxes(bullet_count, 0.005f, 0.02f, 1);
+	Boxes enemies = random_boxes(enemy_count, 0.04f, 0.04f, 2);
+
+	std::printf("Collision: %zu bullets vs %zu enemies, average of %d rounds\n", bullet_count, enemy_count, rounds);
+
+	SpatialGrid grid;
+	grid.init(-1.0f, -1.0f, 1.0f, 1.0f, 32, 32, enemy_count);
+
+	Clock::time_point start = Clock::now();
+	for (size_t e = 0; e < enemy_count; ++e)
+	{
+		grid.insert(static_cast<std::uint32_t>(e), enemies.x[e], enemies.y[e], enemies.hw[e], enemies.hh[e]);
+	}
+	double build_ms = ms_since(start);
+
+	// A tick's worth of movement, most enemies stay in their cell
+	start = Clock::now();
+	for (size_t e = 0; e < enemy_count; ++e)
+	{
+		enemies.x[e] += 0.004f;
+		grid.move(static_cast<std::uint32_t>(e), enemies.x[e], enemies.y[e]);
+	}
+	double move_ms = ms_since(start);
+
+	std::vector<std::uint32_t> candidates(enemy_count);
+	size_t grid_total = 0;
+	size_t candidate_total = 0;
+	start = Clock::now();
+	for (int r = 0; r < rounds; ++r)
+	{
+		for (size_t b = 0; b < bullet_count; ++b)
+		{
+			size_t n = grid.query(bullets.x[b] - bullets.hw[b], bullets.y[b] - bullets.hh[b],
+				bullets.x[b] + bullets.hw[b], bullets.y[b] + bullets.hh[b], candidates.data(), candidates.size());
+			candidate_total += n;
+			for (size_t c = 0; c < n; ++c)
+			{
+				grid_total += overlaps(bullets, b, enemies, candidates[c]);
+			}
+		}
+	}
+	double grid_ms = ms_since(start) / rounds;
+	size_t grid_hits = grid_total / rounds;
+
+	// Brute force: every bullet against every enemy
+	size_t brute_total = 0;
+	start = Clock::now();
+	for (int r = 0; r < rounds; ++r)
+	{
+		for (size_t b = 0; b < bullet_count; ++b)
+		{
+			for (size_t e = 0; e < enemy_count; ++e)
+			{
+				brute_total += overlaps(bullets, b, enemies, e);
+			}
+		}
+	}
+	double brute_ms = ms_since(start) / rounds;
+	size_t brute_hits = brute_total / rounds;
+
+	std::printf("  brute force: %8.3f ms/tick\n", brute_ms);
+	std::printf("  grid build:  %8.3f ms (once), incremental move: %.3f ms/tick\n", build_ms, move_ms);
+	std::printf("  grid query:  %8.3f ms/tick (%.1f candidates/bullet), %.1fx faster\n",
+		grid_ms, static_cast<double>(candidate_total) / (bullet_count * rounds), brute_ms / grid_ms);
+	std::printf("  hits: brute %zu, grid %zu %s\n", brute_hits, grid_hits, brute_hits == grid_hits ? "(match)" : "(MISMATCH)");
+	return brute_hits == grid_hits;
+}
+
+bool bench_kernel()
+{
+	const size_t count = 1027; // Not a multiple of 8 so the scalar tails run too
+	const int queries = 20000;
+
+	// Boxes snapped to a coarse grid so plenty of them touch the query exactly on an edge
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<int> cell(-40, 40);
+	std::vector<float> min_x(count), min_y(count), max_x(count), max_y(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		min_x[i] = cell(rng) * 0.025f;
+		min_y[i] = cell(rng) * 0.025f;
+		max_x[i] = min_x[i] + 0.025f * (1 + cell(rng) % 3 + 2);
+		max_y[i] = min_y[i] + 0.025f * (1 + cell(rng) % 3 + 2);
+	}
+
+	// A NaN coordinate must never overlap anything, in any lane of any path
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	for (size_t i = 5; i < count; i += 37)
+	{
+		(i % 4 == 0 ? min_x : i % 4 == 1 ? min_y : i % 4 == 2 ? max_x : max_y)[i] = nan;
+	}
+	AabbBatch batch = { min_x.data(), min_y.data(), max_x.data(), max_y.data(), count };
+
+	std::vector<Aabb> boxes(queries);
+	for (Aabb& box : boxes)
+	{
+		box.min_x = cell(rng) * 0.025f;
+		box.min_y = cell(rng) * 0.025f;
+		box.max_x = box.min_x + 0.1f;
+		box.max_y = box.min_y + 0.1f;
+	}
+	for (size_t q = 11; q < boxes.size(); q += 101)
+	{
+		(q % 2 ? boxes[q].min_x : boxes[q].max_y) = nan;
+	}
+
+	struct Path
+	{
+		const char* name;
+		size_t (*fn)(const Aabb&, const AabbBatch&, std::uint8_t*);
+		bool available;
+	};
+	const Path paths[] = {
+		{ "scalar", overlap_aabb_scalar, true },
+		{ "sse2", overlap_aabb_sse, cpu_has_sse2() },
+		{ "avx2", overlap_aabb_avx2, cpu_has_avx2() },
+	};
+
+	std::printf("Collision kernel: %zu candidates x %d queries, dispatching to %s\n", count, queries, collision_kernel_name());
+
+	std::vector<std::uint8_t> reference(count * queries);
+	std::vector<std::uint8_t> out(count * queries);
+
+	bool all_identical = true;
+	for (const Path& path : paths)
+	{
+		if (!path.available)
+		{
+			std::printf("  %-6s   not supported on this CPU\n", path.name);
+			continue;
+		}
+
+		std::uint8_t* dst = path.fn == overlap_aabb_scalar ? reference.data() : out.data();
+
+		size_t hits = 0;
+		Clock::time_point start = Clock::now();
+		for (int q = 0; q < queries; ++q)
+		{
+			hits += path.fn(boxes[q], batch, dst + q * count);
+		}
+		double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (static_cast<double>(count) * queries);
+
+		const char* verdict = "reference";
+		if (dst != reference.data())
+		{
+			bool identical = std::memcmp(reference.data(), out.data(), out.size()) == 0;
+			verdict = identical ? "identical to scalar" : "DIFFERS FROM SCALAR";
+			all_identical = all_identical && identical;
+		}
+		std::printf("  %-6s %6.3f ns/box, %zu hits, %s\n", path.name, ns, hits, verdict);
+	}
+	return all_identical;
+}
+
+bool bench_jobs()
+{
+	const int thread_counts[] = { 1, 2, 4, 8 };
+	const size_t sprites = 200000;
+	const int frames = 200;
+	const int ticks = 4000;
+
+	Level level;
+	if (!load_level("assets/levels/stress.lvl", nullptr, level))
+	{
+		return false;
+	}
+
+	std::printf("Job system scaling (%u hardware threads)\n", std::thread::hardware_concurrency());
+	std::printf("  threads | stress scene, %zu sprites | stress level, %d ticks\n", sprites, ticks);
+
+	double base_frame_ms = 0.0;
+	double base_tick_ms = 0.0;
+	std::uint64_t base_checksum = 0;
+	bool all_same = true;
+	std::vector<SpriteInstance> instances(sprites);
+
+	for (int threads : thread_counts)
+	{
+		JobSystem jobs;
+		jobs.init(threads);
+
+		// One tick of the stress scene plus building its instance buffer, as a frame would
+		StressScene scene;
+		scene.init(sprites, 1234);
+		Clock::time_point start = Clock::now();
+		for (int f = 0; f < frames; ++f)
+		{
+			scene.update(TICK_DT, &jobs);
+			build_entity_instances(scene.entities, 0.5f, instances.data(), &jobs);
+		}
+		double frame_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / frames;
+
+		// The whole game tick on the stress level, nobody at the controls
+		GameState game;
+		game_init(game, &level, &jobs);
+		InputQueue inputs;
+		start = Clock::now();
+		for (int t = 0; t < ticks; ++t)
+		{
+			game_step(game, inputs, TICK_DT);
+		}
+		double tick_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / ticks;
+		std::uint64_t checksum = game_checksum(game);
+
+		if (threads == 1)
+		{
+			base_frame_ms = frame_ms;
+			base_tick_ms = tick_ms;
+			base_checksum = checksum;
+		}
+		all_same = all_same && checksum == base_checksum;
+
+		std::printf("  %7d | %7.3f ms/frame  %5.2fx        | %7.3f ms/tick  %5.2fx  %s\n", threads,
+			frame_ms, base_frame_ms / frame_ms, tick_ms, base_tick_ms / tick_ms,
+			checksum == base_checksum ? "same state" : "STATE DIFFERS");
+	}
+	return all_same;
+}
+
+bool bench_particles()
+{
+	const size_t count = 100000;
+	const int ticks = 1000;
+
+	struct Path
+	{
+		const char* name;
+		ParticleKernel kernel;
+		bool available;
+	};
+	const Path paths[] = {
+		{ "scalar", PARTICLE_KERNEL_SCALAR, true },
+		{ "sse2", PARTICLE_KERNEL_SSE2, cpu_has_sse2() },
+	};
+
+	std::printf("Particles: %zu live, %d ticks, %zu bytes each, update dispatches to %s\n", count, ticks,
+		2 * sizeof(std::int16_t) * 2 + sizeof(std::uint16_t) + sizeof(std::uint8_t), particle_kernel_name());
+
+	ParticleSystem reference;
+	bool all_identical = true;
+	for (const Path& path : paths)
+	{
+		if (!path.available)
+		{
+			std::printf("  %-6s   not supported on this CPU\n", path.name);
+			continue;
+		}
+
+		// Explosions all over the field that outlive the run, so the count stays put
+		ParticleSystem particles;
+		particles.init(count);
+		std::mt19937 rng(99);
+		std::uniform_real_distribution<float> pos(-0.9f, 0.9f);
+		while (particles.size() < count)
+		{
+			particles.emit(PARTICLE_SPARK, pos(rng), pos(rng), EXPLOSION_SPARKS, 0.0f, 0.0f, 0.5f, 60000);
+		}
+
+		Clock::time_point start = Clock::now();
+		for (int t = 0; t < ticks; ++t)
+		{
+			particles.update(path.kernel);
+		}
+		double ms = ms_since(start);
+
+		const char* verdict = "reference";
+		if (path.kernel == PARTICLE_KERNEL_SCALAR)
+		{
+			reference.copy_for_render(particles);
+		}
+		else
+		{
+			const size_t n = particles.size();
+			bool same = n == reference.size()
+				&& std::equal(particles.pos_x.begin(), particles.pos_x.begin() + n, reference.pos_x.begin())
+				&& std::equal(particles.pos_y.begin(), particles.pos_y.begin() + n, reference.pos_y.begin())
+				&& std::equal(particles.vel_x.begin(), particles.vel_x.begin() + n, reference.vel_x.begin())
+				&& std::equal(particles.vel_y.begin(), particles.vel_y.begin() + n, reference.vel_y.begin())
+				&& std::equal(particles.life.begin(), particles.life.begin() + n, reference.life.begin());
+			verdict = same ? "identical to scalar" : "DIFFERS FROM SCALAR";
+			all_identical = all_identical && same;
+		}
+		std::printf("  %-6s %8.3f ms/tick, %9.0f particles/ms, %zu still live, %s\n", path.name, ms / ticks,
+			static_cast<double>(count) * ticks / ms, particles.size(), verdict);
+	}
+	return all_identical;
+}
+
+void bench_culling()
+{
+	const size_t enemies = 12000;
+	const int ticks = 1200;
+
+	// Twenty screens side by side with enemies drifting all over them, all spawned at once and
+	// slow enough that few leave, so only about one in ten is on screen at any time
+	Level level;
+	level.world = { -10.0f, -1.0f, 10.0f, 1.0f };
+	std::mt19937 rng(321);
+	std::uniform_real_distribution<float> pos_x(level.world.min_x, level.world.max_x);
+	std::uniform_real_distribution<float> pos_y(-0.5f, 0.95f);
+	std::uniform_real_distribution<float> vel(-0.05f, 0.05f);
+	for (size_t i = 0; i < enemies; ++i)
+	{
+		level.spawns.push_back({ 0, pos_x(rng), pos_y(rng), vel(rng), 0.0f });
+	}
+	level.length = 1;
+
+	RenderSnapshot snapshot;
+	snapshot.entities.reserve(MAX_ENTITIES);
+	snapshot.effects.resize(MAX_EFFECTS);
+	snapshot.particles.init(MAX_PARTICLES);
+	std::vector<SpriteInstance> instances(MAX_ENTITIES + MAX_PARTICLES);
+
+	std::printf("Culling: %zu enemies over a %.0fx%.0f world (%.0f%% on screen), %d ticks scrolling right\n", enemies,
+		level.world.max_x - level.world.min_x, level.world.max_y - level.world.min_y,
+		100.0f * (4.0f * VIEW_HALF_W * VIEW_HALF_H) / ((level.world.max_x - level.world.min_x) * (level.world.max_y - level.world.min_y)), ticks);
+
+	GameState game;
+	game_init(game, &level);
+
+	// Hold 'd' for the whole run, the camera follows the player across the world
+	InputQueue inputs;
+	InputEvent event;
+	event.type = INPUT_KEY_DOWN;
+	event.key = 'd';
+	inputs.push(event);
+
+	// The simulation never looks at the camera, so one run feeds both: every tick is captured and
+	// turned into instances once over the whole world and once through the camera
+	double frame_ms[2] = {};
+	size_t sprites[2] = {};
+	size_t particles[2] = {};
+	for (int t = 0; t < ticks; ++t)
+	{
+		game_step(game, inputs, TICK_DT);
+
+		for (int cull = 0; cull < 2; ++cull)
+		{
+			Clock::time_point start = Clock::now();
+			capture_snapshot(snapshot, game.entities, &game.effects, &game.particles, cull ? &game.camera : nullptr,
+				cull ? &game.prev_camera : nullptr, game.tick, 0.5f);
+			build_entity_instances(snapshot.entities, 0.5f, instances.data(), nullptr);
+			build_particle_instances(snapshot.particles, 0, snapshot.particles.size(), 0.5f, instances.data() + snapshot.entities.size());
+			frame_ms[cull] += ms_since(start);
+			sprites[cull] += snapshot.entities.size();
+			particles[cull] += snapshot.particles.size();
+		}
+	}
+
+	for (int cull = 0; cull < 2; ++cull)
+	{
+		std::printf("  %-11s %7.3f ms/frame %5.2fx | %6zu sprites/frame, %6zu particles/frame\n", cull ? "culled" : "not culled",
+			frame_ms[cull] / ticks, frame_ms[0] / frame_ms[cull], sprites[cull] / ticks, particles[cull] / ticks);
+	}
+	std::printf("  camera ended at x %.2f\n", game.camera.x);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+//=================================================================================================
+// BENCHMARKS
+//
+// Command line modes that run without creating a window and print their results to stdout.
+// Modes that cross-check two implementations return false when they disagree, so main can turn a
+// regression into a failing exit code.
+//=================================================================================================
+
+// --bench-entities: EntityStore::update cost per entity at 1k, 10k and 100k entities
+void bench_entities();
+
+// --bench-collision: brute force vs. SpatialGrid for 10k bullets against 1k enemies, false if
+// they find a different number of hits
+bool bench_collision();
+
+// --bench-kernel: scalar, SSE2 and AVX2 collision kernels, false unless they agree bit for bit,
+// edge-touching and NaN boxes included
+bool bench_kernel();
+
+// --bench-jobs: stress scene update + instance build and the stress level tick on 1, 2, 4 and 8
+// job threads, false unless the game ends in the same state on all of them
+bool bench_jobs();
+
+// --bench-particles: particles updated per millisecond with the scalar and SSE2 kernels, false
+// unless they end in exactly the same state
+bool bench_particles();
+
+// --bench-culling: a level twenty screens wide with 90% of its enemies off-screen, scrolled across
+// and drawn with and without culling the render snapshot: snapshot plus instance build time, and
+// sprites and particles submitted per frame
+void bench_culling();
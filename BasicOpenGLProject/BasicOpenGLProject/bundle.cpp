@@ -0,0 +1,241 @@
+#include "bundle.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char BUNDLE_MAGIC[4] = { 'A', 'B', 'D', 'L' };
+
+//=================================================================================================
+// MAPPED FILE
+//=================================================================================================
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(handle);
+		return false;
+	}
+
+	file_handle = handle;
+	mapping_handle = mapping;
+	bytes = static_cast<const unsigned char*>(view);
+	length = static_cast<size_t>(file_size.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes)
+	{
+		UnmapViewOfFile(bytes);
+		CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+	}
+	bytes = nullptr;
+	length = 0;
+	file_handle = nullptr;
+	mapping_handle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	bytes = static_cast<const unsigned char*>(view);
+	length = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes)
+	{
+		munmap(const_cast<unsigned char*>(bytes), length);
+	}
+	bytes = nullptr;
+	length = 0;
+}
+
+#endif
+
+//=================================================================================================
+// ASSET BUNDLE
+//=================================================================================================
+
+bool AssetBundle::open(const std::string& path)
+{
+	close();
+	if (!file.open(path))
+	{
+		return false;
+	}
+
+	const size_t size = file.size();
+	if (size < sizeof(BundleHeader))
+	{
+		close();
+		return false;
+	}
+
+	const BundleHeader* header = reinterpret_cast<const BundleHeader*>(file.data());
+	if (std::memcmp(header->magic, BUNDLE_MAGIC, 4) != 0 || header->version != BUNDLE_VERSION
+		|| header->index_offset % BUNDLE_ALIGNMENT != 0 || header->index_offset > size
+		|| (size - header->index_offset) / sizeof(BundleEntry) < header->entry_count)
+	{
+		close();
+		return false;
+	}
+
+	const BundleEntry* index = reinterpret_cast<const BundleEntry*>(file.data() + header->index_offset);
+	for (std::uint32_t i = 0; i < header->entry_count; ++i)
+	{
+		const BundleEntry& entry = index[i];
+		if (std::memchr(entry.name, 0, sizeof(entry.name)) == nullptr
+			|| entry.offset % BUNDLE_ALIGNMENT != 0 || entry.offset > size || size - entry.offset < entry.size)
+		{
+			close();
+			return false;
+		}
+	}
+
+	entries = index;
+	count = header->entry_count;
+	return true;
+}
+
+void AssetBundle::close()
+{
+	file.close();
+	entries = nullptr;
+	count = 0;
+}
+
+const BundleEntry* AssetBundle::find(const char* name, BundleAssetType type) const
+{
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		if (entries[i].type == static_cast<std::uint32_t>(type) && std::strcmp(entries[i].name, name) == 0)
+		{
+			return &entries[i];
+		}
+	}
+	return nullptr;
+}
+
+//=================================================================================================
+// WRITING
+//=================================================================================================
+
+static size_t align_up(size_t v)
+{
+	return (v + BUNDLE_ALIGNMENT - 1) & ~(BUNDLE_ALIGNMENT - 1);
+}
+
+bool write_bundle(const std::string& path, const std::vector<BundleInput>& inputs)
+{
+	// Header, then the blobs, then the index at the end
+	std::vector<unsigned char> out(sizeof(BundleHeader), 0);
+	std::vector<BundleEntry> index(inputs.size());
+
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		const BundleInput& input = inputs[i];
+		if (input.name.size() >= sizeof(index[i].name))
+		{
+			std::printf("Asset name too long for a bundle: %s\n", input.name.c_str());
+			return false;
+		}
+
+		out.resize(align_up(out.size()), 0);
+
+		BundleEntry& entry = index[i];
+		std::memset(&entry, 0, sizeof(entry));
+		std::memcpy(entry.name, input.name.c_str(), input.name.size());
+		entry.type = input.type;
+		entry.offset = static_cast<std::uint32_t>(out.size());
+		entry.size = static_cast<std::uint32_t>(input.bytes.size());
+
+		out.insert(out.end(), input.bytes.begin(), input.bytes.end());
+	}
+
+	out.resize(align_up(out.size()), 0);
+
+	BundleHeader header;
+	std::memcpy(header.magic, BUNDLE_MAGIC, 4);
+	header.version = BUNDLE_VERSION;
+	header.entry_count = static_cast<std::uint32_t>(index.size());
+	header.index_offset = static_cast<std::uint32_t>(out.size());
+	std::memcpy(out.data(), &header, sizeof(header));
+
+	const unsigned char* index_bytes = reinterpret_cast<const unsigned char*>(index.data());
+	out.insert(out.end(), index_bytes, index_bytes + index.size() * sizeof(BundleEntry));
+
+	FILE* file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+	return std::fclose(file) == 0 && ok;
+}
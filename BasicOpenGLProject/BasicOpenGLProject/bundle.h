@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//=================================================================================================
+// ASSET BUNDLE
+//
+// All game assets in one file: a header, an index of fixed-size entries and the blobs they point
+// at, each aligned to 16 bytes. The file is memory mapped and nothing is copied out of it; the
+// index is searched in place and callers get pointers straight into the mapping (textures are
+// uploaded from it, level data is read from it). Build bundles with --pack-bundle.
+//=================================================================================================
+
+enum BundleAssetType
+{
+	BUNDLE_RAW = 0, // Bytes as they were on disk
+	BUNDLE_TEXTURE = 1, // BundleTexture followed by width * height RGBA pixels
+	BUNDLE_ATLAS_REGIONS = 2, // Array of BundleRegion
+};
+
+// Everything below is little-endian and read in place, so the layouts must not change without
+// bumping BUNDLE_VERSION
+const std::uint32_t BUNDLE_VERSION = 1;
+const size_t BUNDLE_ALIGNMENT = 16;
+
+struct BundleHeader
+{
+	char magic[4]; // "ABDL"
+	std::uint32_t version;
+	std::uint32_t entry_count;
+	std::uint32_t index_offset;
+};
+
+struct BundleEntry
+{
+	char name[48]; // Zero-terminated
+	std::uint32_t type;
+	std::uint32_t reserved;
+	std::uint32_t offset; // From the start of the file
+	std::uint32_t size;
+};
+
+struct BundleTexture
+{
+	std::uint32_t width;
+	std::uint32_t height;
+};
+
+struct BundleRegion
+{
+	char name[32]; // Zero-terminated
+	std::uint32_t x, y, width, height;
+};
+
+static_assert(sizeof(BundleHeader) == 16, "BundleHeader is read in place");
+static_assert(sizeof(BundleEntry) == 64, "BundleEntry is read in place");
+static_assert(sizeof(BundleRegion) == 48, "BundleRegion is read in place");
+
+// Read-only view of a whole file, unmapped on close or destruction
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile() { close(); }
+
+	bool open(const std::string& path);
+	void close();
+
+	const unsigned char* data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	const unsigned char* bytes = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
+
+class AssetBundle
+{
+public:
+	// Maps the bundle and checks that the header and every entry lie inside the file
+	bool open(const std::string& path);
+	void close();
+
+	bool is_open() const { return entries != nullptr; }
+
+	// nullptr if there is no such asset (or it has a different type)
+	const BundleEntry* find(const char* name, BundleAssetType type) const;
+
+	// Start of an entry's blob inside the mapping
+	const unsigned char* data(const BundleEntry& entry) const { return file.data() + entry.offset; }
+
+	std::uint32_t entry_count() const { return count; }
+	size_t size() const { return file.size(); }
+
+private:
+	MappedFile file;
+	const BundleEntry* entries = nullptr;
+	std::uint32_t count = 0;
+};
+
+// One asset for write_bundle
+struct BundleInput
+{
+	std::string name;
+	BundleAssetType type;
+	std::vector<unsigned char> bytes;
+};
+
+// Lays the inputs out in bundle format and writes them to path
+bool write_bundle(const std::string& path, const std::vector<BundleInput>& inputs);
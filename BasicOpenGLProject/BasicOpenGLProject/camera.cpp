@@ -0,0 +1,35 @@
+#include "camera.h"
+
+static float follow_axis(float target, float world_min, float world_max, float half_view)
+{
+	if (world_max - world_min <= 2.0f * half_view)
+	{
+		return (world_min + world_max) * 0.5f;
+	}
+	if (target < world_min + half_view) return world_min + half_view;
+	if (target > world_max - half_view) return world_max - half_view;
+	return target;
+}
+
+Camera camera_follow(const Aabb& world, float x, float y)
+{
+	Camera camera;
+	camera.x = follow_axis(x, world.min_x, world.max_x, VIEW_HALF_W);
+	camera.y = follow_axis(y, world.min_y, world.max_y, VIEW_HALF_H);
+	return camera;
+}
+
+Camera camera_lerp(const Camera& a, const Camera& b, float t)
+{
+	Camera camera;
+	camera.x = a.x + (b.x - a.x) * t;
+	camera.y = a.y + (b.y - a.y) * t;
+	return camera;
+}
+
+Aabb camera_view(const Camera& camera, float margin)
+{
+	Aabb view = { camera.x - VIEW_HALF_W - margin, camera.y - VIEW_HALF_H - margin,
+		camera.x + VIEW_HALF_W + margin, camera.y + VIEW_HALF_H + margin };
+	return view;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "collision_kernel.h"
+
+//=================================================================================================
+// CAMERA
+//
+// A level can declare a world larger than the screen; the camera shows a window of it,
+// VIEW_HALF_W by VIEW_HALF_H units either side of its centre, through an orthographic projection.
+// The default world is exactly one view, so there the camera never moves and the view is the old
+// [-1, 1] play field. The simulation moves the camera with the player, but only the render
+// snapshot looks at the view: entities, effects and particles outside it are neither copied nor
+// submitted. Off-screen entities are still simulated at full rate. Updating them less often would
+// make collisions and despawns depend on where the camera is, so there is no reduced-rate update,
+// and checksums and replays do not depend on the view.
+//=================================================================================================
+
+const float VIEW_HALF_W = 1.0f;
+const float VIEW_HALF_H = 1.0f;
+
+struct Camera
+{
+	float x = 0.0f, y = 0.0f; // Centre of the view in world units
+};
+
+// Centred on (x, y), then pulled back so the view stays inside world. Centred on the world along
+// any axis where the world is smaller than the view.
+Camera camera_follow(const Aabb& world, float x, float y);
+
+// Between a and b, t in [0, 1]
+Camera camera_lerp(const Camera& a, const Camera& b, float t);
+
+// The part of the world the camera shows, widened by margin on every side
+Aabb camera_view(const Camera& camera, float margin = 0.0f);
+
+// True if a box centred on (x, y) overlaps view
+inline bool box_in_view(const Aabb& view, float x, float y, float half_w, float half_h)
+{
+	return x + half_w >= view.min_x && x - half_w <= view.max_x && y + half_h >= view.min_y && y - half_h <= view.max_y;
+}
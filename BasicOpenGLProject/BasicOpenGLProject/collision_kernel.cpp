@@ -0,0 +1,240 @@
+#include "collision_kernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define COLLISION_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and clang only emit AVX2 instructions inside functions that ask for them
+#if defined(COLLISION_X86) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define TARGET_AVX2
+#define TARGET_SSE2
+#endif
+
+//=================================================================================================
+// CPU FEATURES
+//=================================================================================================
+
+bool cpu_has_sse2()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return true; // Part of the x86-64 baseline
+#elif defined(COLLISION_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#elif defined(COLLISION_X86)
+	__builtin_cpu_init(); // We run from a static initializer, before libgcc may have done this
+	return __builtin_cpu_supports("sse2");
+#else
+	return false;
+#endif
+}
+
+bool cpu_has_avx2()
+{
+#if defined(COLLISION_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	// The OS also has to save the YMM registers on context switches
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(COLLISION_X86)
+	__builtin_cpu_init(); // We run from a static initializer, before libgcc may have done this
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+//=================================================================================================
+// KERNELS
+//=================================================================================================
+
+static size_t overlap_range_scalar(const Aabb& q, const AabbBatch& b, size_t begin, std::uint8_t* out)
+{
+	size_t hits = 0;
+	for (size_t i = begin; i < b.count; ++i)
+	{
+		bool overlap = b.min_x[i] <= q.max_x && b.max_x[i] >= q.min_x
+			&& b.min_y[i] <= q.max_y && b.max_y[i] >= q.min_y;
+		out[i] = overlap ? 1 : 0;
+		hits += overlap;
+	}
+	return hits;
+}
+
+size_t overlap_aabb_scalar(const Aabb& query, const AabbBatch& batch, std::uint8_t* out)
+{
+	return overlap_range_scalar(query, batch, 0, out);
+}
+
+#ifdef COLLISION_X86
+
+TARGET_SSE2 size_t overlap_aabb_sse(const Aabb& q, const AabbBatch& b, std::uint8_t* out)
+{
+	const __m128 q_min_x = _mm_set1_ps(q.min_x);
+	const __m128 q_min_y = _mm_set1_ps(q.min_y);
+	const __m128 q_max_x = _mm_set1_ps(q.max_x);
+	const __m128 q_max_y = _mm_set1_ps(q.max_y);
+
+	size_t hits = 0;
+	size_t i = 0;
+	for (; i + 4 <= b.count; i += 4)
+	{
+		__m128 x = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(b.min_x + i), q_max_x), _mm_cmpge_ps(_mm_loadu_ps(b.max_x + i), q_min_x));
+		__m128 y = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(b.min_y + i), q_max_y), _mm_cmpge_ps(_mm_loadu_ps(b.max_y + i), q_min_y));
+		int mask = _mm_movemask_ps(_mm_and_ps(x, y));
+
+		for (int k = 0; k < 4; ++k)
+		{
+			out[i + k] = static_cast<std::uint8_t>((mask >> k) & 1);
+			hits += out[i + k];
+		}
+	}
+
+	return hits + overlap_range_scalar(q, b, i, out);
+}
+
+TARGET_AVX2 size_t overlap_aabb_avx2(const Aabb& q, const AabbBatch& b, std::uint8_t* out)
+{
+	const __m256 q_min_x = _mm256_set1_ps(q.min_x);
+	const __m256 q_min_y = _mm256_set1_ps(q.min_y);
+	const __m256 q_max_x = _mm256_set1_ps(q.max_x);
+	const __m256 q_max_y = _mm256_set1_ps(q.max_y);
+
+	size_t hits = 0;
+	size_t i = 0;
+	for (; i + 8 <= b.count; i += 8)
+	{
+		// Ordered, non-signalling compares behave like the scalar <= and >= on NaN
+		__m256 x = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b.min_x + i), q_max_x, _CMP_LE_OQ),
+			_mm256_cmp_ps(_mm256_loadu_ps(b.max_x + i), q_min_x, _CMP_GE_OQ));
+		__m256 y = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(b.min_y + i), q_max_y, _CMP_LE_OQ),
+			_mm256_cmp_ps(_mm256_loadu_ps(b.max_y + i), q_min_y, _CMP_GE_OQ));
+		int mask = _mm256_movemask_ps(_mm256_and_ps(x, y));
+
+		for (int k = 0; k < 8; ++k)
+		{
+			out[i + k] = static_cast<std::uint8_t>((mask >> k) & 1);
+			hits += out[i + k];
+		}
+	}
+
+	return hits + overlap_range_scalar(q, b, i, out);
+}
+
+#else
+
+size_t overlap_aabb_sse(const Aabb& query, const AabbBatch& batch, std::uint8_t* out)
+{
+	return overlap_aabb_scalar(query, batch, out);
+}
+
+size_t overlap_aabb_avx2(const Aabb& query, const AabbBatch& batch, std::uint8_t* out)
+{
+	return overlap_aabb_scalar(query, batch, out);
+}
+
+#endif
+
+//=================================================================================================
+// DISPATCH
+//=================================================================================================
+
+typedef size_t (*OverlapFn)(const Aabb&, const AabbBatch&, std::uint8_t*);
+
+static OverlapFn select_kernel(const char** name)
+{
+	if (cpu_has_avx2())
+	{
+		*name = "avx2";
+		return overlap_aabb_avx2;
+	}
+	if (cpu_has_sse2())
+	{
+		*name = "sse2";
+		return overlap_aabb_sse;
+	}
+	*name = "scalar";
+	return overlap_aabb_scalar;
+}
+
+static const char* KernelName = "scalar";
+static const OverlapFn Kernel = select_kernel(&KernelName);
+
+size_t overlap_aabb_batch(const Aabb& query, const AabbBatch& batch, std::uint8_t* out)
+{
+	return Kernel(query, batch, out);
+}
+
+const char* collision_kernel_name()
+{
+	return KernelName;
+}
+
+//=================================================================================================
+// TRIANGLE
+//=================================================================================================
+
+// Projects the triangle and the box on the axis and reports whether the intervals are disjoint
+static bool separated_on(float ax, float ay, const float tri_x[3], const float tri_y[3], const Aabb& box)
+{
+	float t0 = tri_x[0] * ax + tri_y[0] * ay;
+	float t1 = tri_x[1] * ax + tri_y[1] * ay;
+	float t2 = tri_x[2] * ax + tri_y[2] * ay;
+	float t_min = t0 < t1 ? (t0 < t2 ? t0 : t2) : (t1 < t2 ? t1 : t2);
+	float t_max = t0 > t1 ? (t0 > t2 ? t0 : t2) : (t1 > t2 ? t1 : t2);
+
+	// Box centre and radius along the axis
+	float cx = (box.min_x + box.max_x) * 0.5f;
+	float cy = (box.min_y + box.max_y) * 0.5f;
+	float ex = (box.max_x - box.min_x) * 0.5f;
+	float ey = (box.max_y - box.min_y) * 0.5f;
+	float c = cx * ax + cy * ay;
+	float r = ex * (ax < 0 ? -ax : ax) + ey * (ay < 0 ? -ay : ay);
+
+	return t_max < c - r || t_min > c + r;
+}
+
+bool triangle_overlaps_aabb(const float tri_x[3], const float tri_y[3], const Aabb& box)
+{
+	// Box axes
+	if (separated_on(1.0f, 0.0f, tri_x, tri_y, box) || separated_on(0.0f, 1.0f, tri_x, tri_y, box))
+	{
+		return false;
+	}
+
+	// Triangle edge normals
+	for (int i = 0; i < 3; ++i)
+	{
+		int j = (i + 1) % 3;
+		float nx = tri_y[j] - tri_y[i];
+		float ny = tri_x[i] - tri_x[j];
+		if (separated_on(nx, ny, tri_x, tri_y, box))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
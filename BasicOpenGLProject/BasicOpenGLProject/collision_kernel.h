@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//=================================================================================================
+// COLLISION KERNEL
+//
+// Narrow-phase overlap test of one query box against a batch of candidate boxes stored as
+// separate min/max arrays. overlap_aabb_batch uses the widest implementation the CPU supports
+// (AVX2: 8 boxes per compare, SSE2: 4, otherwise scalar), detected once at startup. All paths
+// only compare, never compute, so they produce exactly the same results.
+//=================================================================================================
+
+struct Aabb
+{
+	float min_x, min_y, max_x, max_y;
+};
+
+// Candidate boxes as structure-of-arrays, count entries each
+struct AabbBatch
+{
+	const float* min_x;
+	const float* min_y;
+	const float* max_x;
+	const float* max_y;
+	size_t count;
+};
+
+// Sets out[i] to 1 if candidate i overlaps the query (touching edges count), 0 otherwise.
+// Returns the number of overlaps.
+size_t overlap_aabb_batch(const Aabb& query, const AabbBatch& batch, std::uint8_t* out);
+
+// The individual implementations, for benchmarks and cross-checking
+size_t overlap_aabb_scalar(const Aabb& query, const AabbBatch& batch, std::uint8_t* out);
+size_t overlap_aabb_sse(const Aabb& query, const AabbBatch& batch, std::uint8_t* out);
+size_t overlap_aabb_avx2(const Aabb& query, const AabbBatch& batch, std::uint8_t* out);
+
+bool cpu_has_sse2();
+bool cpu_has_avx2();
+
+// Name of the implementation overlap_aabb_batch dispatches to
+const char* collision_kernel_name();
+
+// Exact separating-axis test between a triangle and a box
+bool triangle_overlaps_aabb(const float tri_x[3], const float tri_y[3], const Aabb& box);
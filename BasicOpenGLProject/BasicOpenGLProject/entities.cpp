@@ -0,0 +1,228 @@
+#include "entities.h"
+#include "camera.h"
+
+#include <algorithm>
+
+static const std::uint32_t INVALID_SLOT = 0xFFFFFFFFu;
+
+void EntityStore::reserve(size_t capacity)
+{
+	if (capacity > pos_x.size())
+	{
+		resize_dense(capacity);
+	}
+	sparse_to_dense.reserve(capacity);
+	generation.reserve(capacity);
+	free_slots.reserve(capacity);
+}
+
+void EntityStore::resize_dense(size_t n)
+{
+	pos_x.resize(n);
+	pos_y.resize(n);
+	prev_x.resize(n);
+	prev_y.resize(n);
+	vel_x.resize(n);
+	vel_y.resize(n);
+	half_w.resize(n);
+	half_h.resize(n);
+	kind.resize(n);
+	flags.resize(n);
+	dense_to_sparse.resize(n);
+}
+
+EntityHandle EntityStore::create(EntityKind entity_kind, float x, float y, float vx, float vy, float hw, float hh)
+{
+	if (count == pos_x.size())
+	{
+		reserve(count < 64 ? 64 : count * 2);
+	}
+
+	EntityHandle handle;
+	if (!free_slots.empty())
+	{
+		handle.index = free_slots.back();
+		free_slots.pop_back();
+	}
+	else
+	{
+		handle.index = static_cast<std::uint32_t>(sparse_to_dense.size());
+		sparse_to_dense.push_back(INVALID_SLOT);
+		generation.push_back(0);
+	}
+	handle.generation = generation[handle.index];
+
+	size_t d = count++;
+	sparse_to_dense[handle.index] = static_cast<std::uint32_t>(d);
+	dense_to_sparse[d] = handle.index;
+
+	pos_x[d] = x;
+	pos_y[d] = y;
+	prev_x[d] = x;
+	prev_y[d] = y;
+	vel_x[d] = vx;
+	vel_y[d] = vy;
+	half_w[d] = hw;
+	half_h[d] = hh;
+	kind[d] = entity_kind;
+	flags[d] = FLAG_NONE;
+
+	return handle;
+}
+
+void EntityStore::destroy(EntityHandle handle)
+{
+	if (valid(handle))
+	{
+		destroy_at(sparse_to_dense[handle.index]);
+	}
+}
+
+void EntityStore::destroy_at(std::uint32_t d)
+{
+	std::uint32_t index = dense_to_sparse[d];
+	std::uint32_t last = static_cast<std::uint32_t>(count - 1);
+
+	if (d != last)
+	{
+		pos_x[d] = pos_x[last];
+		pos_y[d] = pos_y[last];
+		prev_x[d] = prev_x[last];
+		prev_y[d] = prev_y[last];
+		vel_x[d] = vel_x[last];
+		vel_y[d] = vel_y[last];
+		half_w[d] = half_w[last];
+		half_h[d] = half_h[last];
+		kind[d] = kind[last];
+		flags[d] = flags[last];
+
+		dense_to_sparse[d] = dense_to_sparse[last];
+		sparse_to_dense[dense_to_sparse[d]] = d;
+	}
+
+	sparse_to_dense[index] = INVALID_SLOT;
+	generation[index]++;
+	free_slots.push_back(index);
+	count--;
+}
+
+bool EntityStore::valid(EntityHandle handle) const
+{
+	return handle.index < generation.size()
+		&& generation[handle.index] == handle.generation
+		&& sparse_to_dense[handle.index] != INVALID_SLOT;
+}
+
+void EntityStore::clear()
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		std::uint32_t index = dense_to_sparse[i];
+		sparse_to_dense[index] = INVALID_SLOT;
+		generation[index]++;
+		free_slots.push_back(index);
+	}
+	count = 0;
+}
+
+void EntityStore::copy_for_render(const EntityStore& source)
+{
+	const size_t n = source.count;
+	if (n > pos_x.size())
+	{
+		resize_dense(source.pos_x.size());
+	}
+
+	std::copy(source.pos_x.begin(), source.pos_x.begin() + n, pos_x.begin());
+	std::copy(source.pos_y.begin(), source.pos_y.begin() + n, pos_y.begin());
+	std::copy(source.prev_x.begin(), source.prev_x.begin() + n, prev_x.begin());
+	std::copy(source.prev_y.begin(), source.prev_y.begin() + n, prev_y.begin());
+	std::copy(source.half_w.begin(), source.half_w.begin() + n, half_w.begin());
+	std::copy(source.half_h.begin(), source.half_h.begin() + n, half_h.begin());
+	std::copy(source.kind.begin(), source.kind.begin() + n, kind.begin());
+	std::copy(source.flags.begin(), source.flags.begin() + n, flags.begin());
+	count = n;
+}
+
+void EntityStore::copy_for_render(const EntityStore& source, const Aabb& view)
+{
+	if (source.count > pos_x.size())
+	{
+		resize_dense(source.pos_x.size());
+	}
+
+	// A block at a time: which entities are visible is worked out in a loop that vectorizes, then
+	// only those are copied. Testing the box while copying mispredicts on about every other entity.
+	const float* __restrict sx = source.pos_x.data();
+	const float* __restrict sy = source.pos_y.data();
+	const float* __restrict sw = source.half_w.data();
+	const float* __restrict sh = source.half_h.data();
+
+	const size_t BLOCK = 256;
+	std::uint8_t visible[BLOCK];
+	size_t n = 0;
+	for (size_t first = 0; first < source.count; first += BLOCK)
+	{
+		const size_t block = std::min(BLOCK, source.count - first);
+		for (size_t i = 0; i < block; ++i)
+		{
+			const size_t s = first + i;
+			visible[i] = (sx[s] + sw[s] >= view.min_x) & (sx[s] - sw[s] <= view.max_x)
+				& (sy[s] + sh[s] >= view.min_y) & (sy[s] - sh[s] <= view.max_y);
+		}
+
+		for (size_t i = 0; i < block; ++i)
+		{
+			if (!visible[i])
+			{
+				continue;
+			}
+
+			const size_t s = first + i;
+			pos_x[n] = sx[s];
+			pos_y[n] = sy[s];
+			prev_x[n] = source.prev_x[s];
+			prev_y[n] = source.prev_y[s];
+			half_w[n] = sw[s];
+			half_h[n] = sh[s];
+			kind[n] = source.kind[s];
+			flags[n] = source.flags[s];
+			n++;
+		}
+	}
+	count = n;
+}
+
+void EntityStore::update(float dt)
+{
+	update_range(dt, 0, count);
+}
+
+void EntityStore::update_range(float dt, size_t begin, size_t end)
+{
+	const size_t n = end - begin;
+
+	// Separate plain loops over raw pointers so the compiler can vectorize each one
+	float* __restrict px = pos_x.data() + begin;
+	float* __restrict py = pos_y.data() + begin;
+	float* __restrict ox = prev_x.data() + begin;
+	float* __restrict oy = prev_y.data() + begin;
+	const float* __restrict vx = vel_x.data() + begin;
+	const float* __restrict vy = vel_y.data() + begin;
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		ox[i] = px[i];
+		oy[i] = py[i];
+	}
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		px[i] += vx[i] * dt;
+	}
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		py[i] += vy[i] * dt;
+	}
+}
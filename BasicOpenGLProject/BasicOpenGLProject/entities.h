@@ -0,0 +1,92 @@
+#pragma once
+
+#include "collision_kernel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//=================================================================================================
+// ENTITY STORE
+//
+// Structure-of-arrays storage for everything that moves. Live entities are packed at the front of
+// each array (dense slots) so passes are plain linear loops; handles go through a sparse table so
+// they stay valid while other entities are swap-removed around them.
+//=================================================================================================
+
+enum EntityKind : std::uint8_t
+{
+	KIND_PLAYER,
+	KIND_BULLET,
+	KIND_ENEMY,
+};
+
+enum EntityFlags : std::uint8_t
+{
+	FLAG_NONE = 0,
+	FLAG_DEAD = 1 << 0, // Marked for removal at the end of the tick
+};
+
+struct EntityHandle
+{
+	std::uint32_t index = 0xFFFFFFFFu; // Slot in the sparse table
+	std::uint32_t generation = 0; // Bumped every time the slot is reused
+};
+
+class EntityStore
+{
+public:
+	// Pre-sizes every array so creating entities never reallocates below this count
+	void reserve(size_t capacity);
+
+	EntityHandle create(EntityKind kind, float x, float y, float vx, float vy, float half_w, float half_h);
+
+	// O(1): the last dense entity is moved into the freed slot
+	void destroy(EntityHandle handle);
+
+	// Same as destroy() but by dense slot. Safe while iterating slots from the back.
+	void destroy_at(std::uint32_t slot);
+
+	bool valid(EntityHandle handle) const;
+
+	// Dense slot of a live handle, only meaningful until the next create/destroy
+	std::uint32_t slot(EntityHandle handle) const { return sparse_to_dense[handle.index]; }
+
+	// Stable sparse index of the entity in a dense slot, and back
+	std::uint32_t id(std::uint32_t slot) const { return dense_to_sparse[slot]; }
+	std::uint32_t slot_of(std::uint32_t id) const { return sparse_to_dense[id]; }
+
+	size_t size() const { return count; }
+
+	void clear();
+
+	// Copies positions to prev_x/prev_y and integrates velocities over dt
+	void update(float dt);
+
+	// Copies what rendering needs (positions, sizes, kinds, flags) from source. The copy's handles
+	// are meaningless; it only exists to be drawn. Allocates only if source has grown past it.
+	void copy_for_render(const EntityStore& source);
+
+	// Same, but only the entities whose box overlaps view
+	void copy_for_render(const EntityStore& source, const Aabb& view);
+
+	// Same as update for the slots in [begin, end), so disjoint ranges can run on different threads
+	void update_range(float dt, size_t begin, size_t end);
+
+	// Dense arrays, valid for [0, size())
+	std::vector<float> pos_x, pos_y;
+	std::vector<float> prev_x, prev_y;
+	std::vector<float> vel_x, vel_y;
+	std::vector<float> half_w, half_h;
+	std::vector<std::uint8_t> kind;
+	std::vector<std::uint8_t> flags;
+
+private:
+	void resize_dense(size_t n);
+
+	size_t count = 0;
+	std::vector<std::uint32_t> dense_to_sparse;
+	std::vector<std::uint32_t> sparse_to_dense;
+	std::vector<std::uint32_t> generation;
+	std::vector<std::uint32_t> free_slots;
+};
@@ -0,0 +1,66 @@
+#include "entity_sprites.h"
+
+static const size_t BUILD_GRAIN = 4096;
+
+void build_entity_instances(const EntityStore& entities, float alpha, SpriteInstance* out, JobSystem* jobs)
+{
+	auto build = [&entities, alpha, out](size_t begin, size_t end, int)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			// Draw between the last two ticks so motion stays smooth at any frame rate
+			SpriteInstance& instance = out[i];
+			instance.x = entities.prev_x[i] + (entities.pos_x[i] - entities.prev_x[i]) * alpha;
+			instance.y = entities.prev_y[i] + (entities.pos_y[i] - entities.prev_y[i]) * alpha;
+
+			if (entities.kind[i] == KIND_PLAYER)
+			{
+				instance.w = 0.0f;
+				instance.h = 0.0f;
+			}
+			else
+			{
+				instance.w = entities.half_w[i] * 2.0f;
+				instance.h = entities.half_h[i] * 2.0f;
+			}
+			instance.color = ENTITY_COLORS[entities.kind[i]];
+		}
+	};
+
+	if (jobs)
+	{
+		jobs->parallel_for(entities.size(), BUILD_GRAIN, build);
+	}
+	else
+	{
+		build(0, entities.size(), 0);
+	}
+}
+
+void build_particle_instances(const ParticleSystem& particles, size_t begin, size_t end, float alpha, SpriteInstance* out)
+{
+	const float scale = 1.0f / ParticleSystem::UNITS;
+	const float fade = 255.0f / ParticleSystem::FADE_TICKS;
+	const float origin_x = particles.origin_x();
+	const float origin_y = particles.origin_y();
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		SpriteInstance& instance = out[i - begin];
+		instance.x = origin_x + (particles.pos_x[i] + particles.vel_x[i] * alpha) * scale;
+		instance.y = origin_y + (particles.pos_y[i] + particles.vel_y[i] * alpha) * scale;
+
+		int life = particles.life[i];
+		unsigned char a = static_cast<unsigned char>(life >= ParticleSystem::FADE_TICKS ? 255 : life * fade);
+		if (particles.kind[i] == PARTICLE_SPARK)
+		{
+			instance.w = instance.h = 0.008f;
+			instance.color = { 255, 176, 48, a };
+		}
+		else
+		{
+			instance.w = instance.h = 0.012f;
+			instance.color = { 128, 192, 255, static_cast<unsigned char>(a / 2) };
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "entities.h"
+#include "instanced_batch.h"
+#include "jobs.h"
+#include "particles.h"
+
+//=================================================================================================
+// ENTITY SPRITES
+//
+// Turns the entity and particle arrays into instance records for the instanced batch. Every slot writes only
+// its own record, so the work splits across the job system with no coordination at all.
+//=================================================================================================
+
+// Colour of each entity kind, indexed by EntityKind; shared by the instanced and fallback paths
+const Color ENTITY_COLORS[] = {
+	{ 255, 255, 255, 255 }, // KIND_PLAYER, tints the player sprite
+	{ 255, 220, 64, 255 }, // KIND_BULLET
+	{ 220, 48, 48, 255 }, // KIND_ENEMY
+};
+
+// Writes one instance per entity slot into out (entities.size() records), interpolated between
+// the last two ticks by alpha. Players get an empty record since they are drawn separately.
+void build_entity_instances(const EntityStore& entities, float alpha, SpriteInstance* out, JobSystem* jobs);
+
+// Writes one instance per particle in [begin, end) into out, moved on by alpha ticks of velocity
+// and faded out over the particle's last ticks
+void build_particle_instances(const ParticleSystem& particles, size_t begin, size_t end, float alpha, SpriteInstance* out);
@@ -0,0 +1,240 @@
+#include "font.h"
+
+#include <algorithm>
+#include <cstring>
+
+const int BitmapFont::FIRST_CHAR;
+const int BitmapFont::GLYPH_COUNT;
+
+static const int PAGE_COLUMNS = 16; // Glyph cells per row of the page
+static const int CELL_W = GLYPH_W + 1; // A transparent pixel right of and below every glyph keeps
+static const int CELL_H = GLYPH_H + 1; // neighbours from bleeding in
+static const int PAGE_W = 128; // Power-of-two sizes for the fixed-function path
+static const int PAGE_H = 32;
+
+static_assert(PAGE_COLUMNS * CELL_W <= PAGE_W, "glyph rows do not fit the page");
+static_assert((BitmapFont::GLYPH_COUNT + PAGE_COLUMNS - 1) / PAGE_COLUMNS * CELL_H <= PAGE_H, "glyph columns do not fit the page");
+
+// One byte per row, top row first, bit 4 is the leftmost pixel
+static const unsigned char GLYPHS[BitmapFont::GLYPH_COUNT][GLYPH_H] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+	{ 0x04, 0x04, 0x04, 0x04, 0x00, 0x00, 0x04 }, // !
+	{ 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 }, // "
+	{ 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A }, // #
+	{ 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 }, // $
+	{ 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // %
+	{ 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D }, // &
+	{ 0x0C, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 }, // '
+	{ 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // (
+	{ 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // )
+	{ 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 }, // *
+	{ 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 }, // +
+	{ 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 }, // ,
+	{ 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // -
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C }, // .
+	{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // /
+	{ 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // 0
+	{ 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 1
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // 2
+	{ 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // 3
+	{ 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // 4
+	{ 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // 5
+	{ 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // 6
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+	{ 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // 8
+	{ 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // 9
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // :
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 }, // ;
+	{ 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, // <
+	{ 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 }, // =
+	{ 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, // >
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // ?
+	{ 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E }, // @
+	{ 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 }, // A
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, // B
+	{ 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // C
+	{ 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, // D
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // E
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, // F
+	{ 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // G
+	{ 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // H
+	{ 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // I
+	{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, // J
+	{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // K
+	{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, // L
+	{ 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // M
+	{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // N
+	{ 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // O
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, // P
+	{ 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // Q
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, // R
+	{ 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // S
+	{ 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // T
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // U
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // V
+	{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // W
+	{ 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, // X
+	{ 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 }, // Y
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }, // Z
+	{ 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E }, // [
+	{ 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 }, // backslash
+	{ 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E }, // ]
+	{ 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 }, // ^
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F }, // _
+};
+
+//=================================================================================================
+// FONT
+//=================================================================================================
+
+void BitmapFont::init()
+{
+	image.width = PAGE_W;
+	image.height = PAGE_H;
+	image.rgba.assign(static_cast<size_t>(PAGE_W) * PAGE_H * 4, 0);
+
+	for (int g = 0; g < GLYPH_COUNT; ++g)
+	{
+		const int cell_x = (g % PAGE_COLUMNS) * CELL_W;
+		const int cell_y = (g / PAGE_COLUMNS) * CELL_H;
+		for (int row = 0; row < GLYPH_H; ++row)
+		{
+			for (int column = 0; column < GLYPH_W; ++column)
+			{
+				if (GLYPHS[g][row] & (0x10 >> column))
+				{
+					unsigned char* pixel = &image.rgba[((cell_y + row) * PAGE_W + cell_x + column) * 4];
+					pixel[0] = pixel[1] = pixel[2] = pixel[3] = 255;
+				}
+			}
+		}
+
+		uvs[g].u0 = static_cast<float>(cell_x) / PAGE_W;
+		uvs[g].v0 = static_cast<float>(cell_y) / PAGE_H;
+		uvs[g].u1 = static_cast<float>(cell_x + GLYPH_W) / PAGE_W;
+		uvs[g].v1 = static_cast<float>(cell_y + GLYPH_H) / PAGE_H;
+	}
+}
+
+GLuint BitmapFont::upload()
+{
+	if (image.rgba.empty())
+	{
+		return 0;
+	}
+
+	glGenTextures(1, &texture_id);
+	glBindTexture(GL_TEXTURE_2D, texture_id);
+
+	// Pixel font: no filtering, and rows are tightly packed
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.rgba.data());
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture_id;
+}
+
+void BitmapFont::shutdown()
+{
+	if (texture_id != 0)
+	{
+		glDeleteTextures(1, &texture_id);
+		texture_id = 0;
+	}
+}
+
+const UvRect& BitmapFont::glyph(char c) const
+{
+	if (c >= 'a' && c <= 'z')
+	{
+		c = static_cast<char>(c - 'a' + 'A');
+	}
+	int index = static_cast<unsigned char>(c) - FIRST_CHAR;
+	if (index < 0 || index >= GLYPH_COUNT)
+	{
+		index = '?' - FIRST_CHAR;
+	}
+	return uvs[index];
+}
+
+Material BitmapFont::material() const
+{
+	Material material;
+	material.texture = texture_id;
+	return material;
+}
+
+//=================================================================================================
+// TEXT RUNS
+//=================================================================================================
+
+void TextRun::init(const BitmapFont* text_font, size_t max_chars)
+{
+	font = text_font;
+	capacity = max_chars;
+	current.reserve(max_chars);
+	vertices.reserve(max_chars * 6);
+}
+
+bool TextRun::set(const char* text, float x, float y, float pixel_w, float pixel_h, Color color)
+{
+	const size_t length = std::min(std::strlen(text), capacity);
+	bool same = current.size() == length && std::memcmp(current.data(), text, length) == 0
+		&& x == left && y == top && pixel_w == pixel_width && pixel_h == pixel_height
+		&& color.r == tint.r && color.g == tint.g && color.b == tint.b && color.a == tint.a;
+	if (same || !font)
+	{
+		return false;
+	}
+
+	current.assign(text, length);
+	left = x;
+	top = y;
+	pixel_width = pixel_w;
+	pixel_height = pixel_h;
+	tint = color;
+	text_width = 0.0f;
+	rebuild_count++;
+
+	// Same vertex order as SpriteBatch::add_sprite
+	const float w = GLYPH_W * pixel_w;
+	const float h = GLYPH_H * pixel_h;
+	float pen_x = x;
+	float pen_y = y - h; // Bottom of the first line
+	vertices.clear();
+	for (char c : current)
+	{
+		if (c == '\n')
+		{
+			pen_x = x;
+			pen_y -= LINE_ADVANCE * pixel_h;
+			continue;
+		}
+
+		if (c != ' ')
+		{
+			const UvRect& uv = font->glyph(c);
+			vertices.push_back({ pen_x, pen_y, uv.u0, uv.v1, color });
+			vertices.push_back({ pen_x + w, pen_y, uv.u1, uv.v1, color });
+			vertices.push_back({ pen_x + w, pen_y + h, uv.u1, uv.v0, color });
+			vertices.push_back({ pen_x, pen_y, uv.u0, uv.v1, color });
+			vertices.push_back({ pen_x + w, pen_y + h, uv.u1, uv.v0, color });
+			vertices.push_back({ pen_x, pen_y + h, uv.u0, uv.v0, color });
+		}
+		text_width = std::max(text_width, pen_x + w - x);
+		pen_x += GLYPH_ADVANCE * pixel_w;
+	}
+	return true;
+}
+
+void TextRun::draw(SpriteBatch& batch) const
+{
+	if (!vertices.empty())
+	{
+		batch.add_vertices(vertices.data(), vertices.size(), font->material());
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "image.h"
+#include "sprite_batch.h"
+
+#include <GL/freeglut.h>
+#include <string>
+#include <vector>
+
+//=================================================================================================
+// BITMAP FONT
+//
+// A 5x7 pixel font compiled into the game and drawn through the sprite batch, so HUD text costs
+// no draw calls of its own (glutBitmapCharacter is one per glyph). The glyphs cover printable ASCII
+// up to '_'; lowercase letters are drawn as uppercase and anything else as '?'.
+//
+// A TextRun keeps the quads of one laid-out string and only lays it out again when the text, its
+// position, size or colour change, so a HUD that changes once a second costs a copy per frame.
+//=================================================================================================
+
+const int GLYPH_W = 5; // Pixels
+const int GLYPH_H = 7;
+const int GLYPH_ADVANCE = GLYPH_W + 1; // One pixel between letters
+const int LINE_ADVANCE = GLYPH_H + 2;
+
+class BitmapFont
+{
+public:
+	static const int FIRST_CHAR = ' ';
+	static const int GLYPH_COUNT = '_' - ' ' + 1;
+
+	// Draws every glyph into the page, no files involved
+	void init();
+
+	// Creates the GL texture from the page, needs a current context
+	GLuint upload();
+	void shutdown();
+
+	// Texture coordinates of the glyph c is drawn with
+	const UvRect& glyph(char c) const;
+
+	Material material() const;
+	const Image& page() const { return image; }
+	GLuint texture() const { return texture_id; }
+
+private:
+	Image image; // White glyphs on transparent, GLYPH_COUNT cells
+	UvRect uvs[GLYPH_COUNT];
+	GLuint texture_id = 0;
+};
+
+class TextRun
+{
+public:
+	// Reserves room for max_chars glyphs, so setting text never allocates. Longer text is cut off.
+	void init(const BitmapFont* font, size_t max_chars);
+
+	// Lays text out from the top-left corner (x, y), each font pixel pixel_w by pixel_h, with '\n'
+	// starting a new line. Returns false and keeps the cached quads when nothing changed.
+	bool set(const char* text, float x, float y, float pixel_w, float pixel_h, Color color);
+
+	// Adds the cached quads to the batch in the font's material
+	void draw(SpriteBatch& batch) const;
+
+	const std::string& text() const { return current; }
+	float width() const { return text_width; } // Of the longest line
+	size_t rebuilds() const { return rebuild_count; }
+
+private:
+	const BitmapFont* font = nullptr;
+	size_t capacity = 0;
+	std::string current;
+	std::vector<SpriteVertex> vertices; // Six per visible glyph
+	float left = 0.0f, top = 0.0f;
+	float pixel_width = 0.0f, pixel_height = 0.0f;
+	Color tint = { 0, 0, 0, 0 };
+	float text_width = 0.0f;
+	size_t rebuild_count = 0;
+};
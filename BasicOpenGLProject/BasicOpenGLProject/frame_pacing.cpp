@@ -0,0 +1,251 @@
+#include "frame_pacing.h"
+
+#include <GL/freeglut.h>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif !defined(__APPLE__)
+#include <GL/glx.h>
+#endif
+
+constexpr float FramePacer::MISS_FACTOR;
+
+const char* vsync_mode_name(VsyncMode mode)
+{
+	switch (mode)
+	{
+	case VSYNC_OFF: return "off";
+	case VSYNC_ON: return "on";
+	case VSYNC_ADAPTIVE: return "adaptive";
+	default: return "?";
+	}
+}
+
+bool parse_vsync_mode(const char* text, VsyncMode& mode)
+{
+	for (int i = VSYNC_OFF; i <= VSYNC_ADAPTIVE; ++i)
+	{
+		VsyncMode candidate = static_cast<VsyncMode>(i);
+		if (std::strcmp(text, vsync_mode_name(candidate)) == 0)
+		{
+			mode = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+//=================================================================================================
+// SWAP CONTROL
+//=================================================================================================
+
+// Whole-word match in a space separated extension list
+static bool has_extension(const char* extensions, const char* name)
+{
+	if (!extensions)
+	{
+		return false;
+	}
+
+	const size_t length = std::strlen(name);
+	for (const char* p = std::strstr(extensions, name); p; p = std::strstr(p + 1, name))
+	{
+		if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+#if defined(_WIN32)
+
+typedef BOOL (WINAPI* PFN_wglSwapIntervalEXT)(int interval);
+typedef const char* (WINAPI* PFN_wglGetExtensionsStringEXT)();
+
+VsyncMode set_swap_interval(VsyncMode mode)
+{
+	PFN_wglSwapIntervalEXT swap_interval = reinterpret_cast<PFN_wglSwapIntervalEXT>(wglGetProcAddress("wglSwapIntervalEXT"));
+	if (!swap_interval)
+	{
+		return VSYNC_OFF;
+	}
+
+	PFN_wglGetExtensionsStringEXT get_extensions = reinterpret_cast<PFN_wglGetExtensionsStringEXT>(wglGetProcAddress("wglGetExtensionsStringEXT"));
+	if (mode == VSYNC_ADAPTIVE && !(get_extensions && has_extension(get_extensions(), "WGL_EXT_swap_control_tear")))
+	{
+		mode = VSYNC_ON;
+	}
+
+	int interval = mode == VSYNC_ADAPTIVE ? -1 : (mode == VSYNC_ON ? 1 : 0);
+	return swap_interval(interval) ? mode : VSYNC_OFF;
+}
+
+#elif defined(__APPLE__)
+
+VsyncMode set_swap_interval(VsyncMode mode)
+{
+	return VSYNC_ON; // GLUT on macOS always syncs to the display
+}
+
+#else
+
+typedef void (*PFN_glXSwapIntervalEXT)(Display* display, GLXDrawable drawable, int interval);
+typedef int (*PFN_glXSwapIntervalMESA)(unsigned int interval);
+typedef int (*PFN_glXSwapIntervalSGI)(int interval);
+
+VsyncMode set_swap_interval(VsyncMode mode)
+{
+	Display* display = glXGetCurrentDisplay();
+	GLXDrawable drawable = glXGetCurrentDrawable();
+	if (!display || !drawable)
+	{
+		return VSYNC_OFF;
+	}
+	const char* extensions = glXQueryExtensionsString(display, DefaultScreen(display));
+
+	if (mode == VSYNC_ADAPTIVE && !has_extension(extensions, "GLX_EXT_swap_control_tear"))
+	{
+		mode = VSYNC_ON;
+	}
+	int interval = mode == VSYNC_ADAPTIVE ? -1 : (mode == VSYNC_ON ? 1 : 0);
+
+	// EXT is per drawable and the only one that knows about adaptive; MESA and SGI are per context
+	if (has_extension(extensions, "GLX_EXT_swap_control"))
+	{
+		PFN_glXSwapIntervalEXT swap_interval = reinterpret_cast<PFN_glXSwapIntervalEXT>(glutGetProcAddress("glXSwapIntervalEXT"));
+		if (swap_interval)
+		{
+			swap_interval(display, drawable, interval);
+			return mode;
+		}
+	}
+	if (mode == VSYNC_ADAPTIVE)
+	{
+		mode = VSYNC_ON;
+		interval = 1;
+	}
+	if (has_extension(extensions, "GLX_MESA_swap_control"))
+	{
+		PFN_glXSwapIntervalMESA swap_interval = reinterpret_cast<PFN_glXSwapIntervalMESA>(glutGetProcAddress("glXSwapIntervalMESA"));
+		if (swap_interval && swap_interval(interval) == 0)
+		{
+			return mode;
+		}
+	}
+	// SGI cannot turn sync off, 0 is an error
+	if (mode == VSYNC_ON && has_extension(extensions, "GLX_SGI_swap_control"))
+	{
+		PFN_glXSwapIntervalSGI swap_interval = reinterpret_cast<PFN_glXSwapIntervalSGI>(glutGetProcAddress("glXSwapIntervalSGI"));
+		if (swap_interval && swap_interval(interval) == 0)
+		{
+			return mode;
+		}
+	}
+	return VSYNC_OFF;
+}
+
+#endif
+
+//=================================================================================================
+// FRAME PACER
+//=================================================================================================
+
+static Clock::duration interval_for(int hz)
+{
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz));
+}
+
+void FramePacer::init(int cap, VsyncMode vsync, int refresh_hz)
+{
+	fps_cap = cap > 0 ? cap : 0;
+	vsync_mode = vsync;
+	frame_time = fps_cap > 0 ? interval_for(fps_cap) : Clock::duration::zero();
+
+	// Vsync cannot present faster than the display, so the slower of the two is what we expect
+	expected = frame_time;
+	if (vsync != VSYNC_OFF && refresh_hz > 0 && interval_for(refresh_hz) > expected)
+	{
+		expected = interval_for(refresh_hz);
+	}
+
+	next_frame = Clock::now();
+	presented = false;
+	frame_stats = PacingStats();
+}
+
+void FramePacer::wait()
+{
+	if (fps_cap == 0)
+	{
+		return;
+	}
+
+	Clock::time_point now = Clock::now();
+	if (now >= next_frame)
+	{
+		// Running behind: start counting again from now rather than bursting frames
+		next_frame = now + frame_time;
+		return;
+	}
+
+	// Sleep most of the way, then spin through the part the OS scheduler cannot hit precisely
+	Clock::time_point wake = next_frame - spin_margin;
+	if (now < wake)
+	{
+		std::this_thread::sleep_until(wake);
+
+		// Learn how late sleeps come back; decay slowly so one hiccup does not keep us spinning
+		Clock::duration overshoot = Clock::now() - wake;
+		spin_margin -= spin_margin / 64;
+		if (overshoot > spin_margin)
+		{
+			spin_margin = overshoot;
+		}
+		const Clock::duration max_margin = std::chrono::milliseconds(4);
+		const Clock::duration min_margin = std::chrono::microseconds(200);
+		spin_margin = spin_margin > max_margin ? max_margin : (spin_margin < min_margin ? min_margin : spin_margin);
+	}
+	while (Clock::now() < next_frame)
+	{
+		std::this_thread::yield();
+	}
+
+	next_frame += frame_time;
+}
+
+void FramePacer::frame_presented(Clock::time_point now)
+{
+	if (presented)
+	{
+		Clock::duration gap = now - last_present;
+		float gap_ms = std::chrono::duration<float, std::milli>(gap).count();
+		if (gap_ms > frame_stats.worst_ms)
+		{
+			frame_stats.worst_ms = gap_ms;
+		}
+		if (expected > Clock::duration::zero() && gap > expected * MISS_FACTOR)
+		{
+			frame_stats.missed++;
+		}
+	}
+
+	presented = true;
+	last_present = now;
+	frame_stats.frames++;
+}
+
+void FramePacer::print_summary() const
+{
+	if (frame_stats.frames == 0)
+	{
+		return;
+	}
+
+	std::printf("Frame pacing: vsync %s, cap %d fps, %llu frames, %llu missed (%.2f%%), worst gap %.2f ms\n",
+		vsync_mode_name(vsync_mode), fps_cap, static_cast<unsigned long long>(frame_stats.frames),
+		static_cast<unsigned long long>(frame_stats.missed), 100.0 * frame_stats.missed / frame_stats.frames, frame_stats.worst_ms);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "game_loop.h"
+
+#include <cstdint>
+
+//=================================================================================================
+// FRAME PACING
+//
+// Decides when frames are presented. The swap interval is set through the window system's
+// swap-control extension (WGL_EXT_swap_control on Windows, GLX_EXT/MESA/SGI_swap_control on X11):
+// with vsync on glutSwapBuffers blocks until the next refresh, adaptive vsync only blocks when the
+// frame was on time and tears instead of dropping to half rate when it was late. On top of that
+// FramePacer caps the frame rate by sleeping most of the way to the next frame and spinning the
+// last fraction of a millisecond, because OS sleeps overshoot by far more than that. Every frame
+// that arrives noticeably later than the target interval is counted as missed.
+//=================================================================================================
+
+enum VsyncMode
+{
+	VSYNC_OFF,
+	VSYNC_ON,
+	VSYNC_ADAPTIVE, // Sync when on time, tear when late
+};
+
+const char* vsync_mode_name(VsyncMode mode);
+
+// Parses "off", "on" or "adaptive". Returns false for anything else.
+bool parse_vsync_mode(const char* text, VsyncMode& mode);
+
+// Sets the swap interval of the current context. Returns the mode actually in effect: adaptive
+// falls back to on without the swap_control_tear extension, and anything falls back to whatever
+// the driver defaults to (reported as off) when no swap-control extension exists at all.
+VsyncMode set_swap_interval(VsyncMode mode);
+
+struct PacingStats
+{
+	std::uint64_t frames = 0;
+	std::uint64_t missed = 0; // Frames that took over MISS_FACTOR times the target interval
+	float worst_ms = 0.0f; // Longest gap between two presents
+};
+
+class FramePacer
+{
+public:
+	// A frame is missed when it comes this much later than the interval it was meant to take
+	static constexpr float MISS_FACTOR = 1.5f;
+
+	// fps_cap 0 turns the limiter off. refresh_hz is the display rate vsync locks to, used as the
+	// expected interval for missed-frame telemetry when there is no cap.
+	void init(int fps_cap, VsyncMode vsync, int refresh_hz);
+
+	int cap() const { return fps_cap; }
+	VsyncMode vsync() const { return vsync_mode; }
+
+	// Blocks until the next capped frame is due. Returns immediately without a cap.
+	void wait();
+
+	// Call right after the swap returns
+	void frame_presented(Clock::time_point now);
+
+	// Drawing stops on purpose because nothing on screen would change; the gap until the next
+	// present is not counted as a missed frame
+	void skip_gap() { presented = false; }
+
+	const PacingStats& stats() const { return frame_stats; }
+
+	void print_summary() const;
+
+private:
+	int fps_cap = 0;
+	VsyncMode vsync_mode = VSYNC_OFF;
+	Clock::duration frame_time = Clock::duration::zero(); // 0 = no limiter
+	Clock::duration expected = Clock::duration::zero(); // 0 = nothing to call a frame late against
+	Clock::time_point next_frame;
+	Clock::duration spin_margin = std::chrono::milliseconds(1); // Grows with the observed sleep overshoot
+	Clock::time_point last_present;
+	bool presented = false;
+	PacingStats frame_stats;
+};
@@ -0,0 +1,462 @@
+#include "game.h"
+
+#include <cmath>
+
+// A fixed formation to shoot at when no level is loaded
+static void spawn_formation(GameState& game)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int col = 0; col < 10; ++col)
+		{
+			game_spawn_enemy(game, -0.72f + col * 0.16f, 0.8f - row * 0.14f, 0.0f, 0.0f);
+		}
+	}
+}
+
+// Spawns everything in the level that is due by now. Once the whole level has spawned and been
+// cleared it starts over.
+static void spawn_from_level(GameState& game)
+{
+	const SpawnEvent* begin = game.level->spawns.data();
+	const SpawnEvent* end = begin + game.level->spawns.size();
+
+	if (game.next_spawn == end && game.enemy_grid.size() == 0)
+	{
+		game.next_spawn = begin;
+		game.level_start = game.tick;
+	}
+
+	// Sorted by tick, so this only ever looks at the spawns that actually happen
+	std::uint32_t t = game.tick - game.level_start;
+	while (game.next_spawn != end && game.next_spawn->tick <= t)
+	{
+		const SpawnEvent& spawn = *game.next_spawn++;
+		game_spawn_enemy(game, spawn.x, spawn.y, spawn.vx, spawn.vy);
+	}
+}
+
+// Cells along one axis of the world, the same size as on the [-1, 1] field
+static int grid_cells(float world_min, float world_max)
+{
+	int cells = static_cast<int>(std::ceil((world_max - world_min) * 0.5f * GRID_CELLS));
+	return cells < 1 ? 1 : (cells > MAX_GRID_CELLS ? MAX_GRID_CELLS : cells);
+}
+
+// The camera follows the player along the world and always shows its bottom edge
+static Camera follow_player(const GameState& game, float player_x)
+{
+	return camera_follow(game.world, player_x, game.world.min_y + VIEW_HALF_H);
+}
+
+void game_init(GameState& game, const Level* level, JobSystem* jobs)
+{
+	const Aabb world = level ? level->world : Aabb{ -1.0f, -1.0f, 1.0f, 1.0f };
+	game.world = world;
+
+	game.entities.clear();
+	game.entities.reserve(MAX_ENTITIES);
+	game.effects.init(MAX_EFFECTS);
+	game.particles.init(MAX_PARTICLES);
+	game.enemy_grid.init(world.min_x, world.min_y, world.max_x, world.max_y,
+		grid_cells(world.min_x, world.max_x), grid_cells(world.min_y, world.max_y), MAX_ENTITIES);
+	game.jobs = jobs;
+	game.scratch.resize(jobs ? jobs->thread_count() : 1);
+	for (CollisionScratch& scratch : game.scratch)
+	{
+		scratch.ids.resize(MAX_COLLISION_CANDIDATES);
+		scratch.min_x.resize(MAX_COLLISION_CANDIDATES);
+		scratch.min_y.resize(MAX_COLLISION_CANDIDATES);
+		scratch.max_x.resize(MAX_COLLISION_CANDIDATES);
+		scratch.max_y.resize(MAX_COLLISION_CANDIDATES);
+		scratch.hits.resize(MAX_COLLISION_CANDIDATES);
+	}
+	game.bullet_targets.resize(MAX_ENTITIES);
+	game.player_hits = 0;
+	game.score = 0;
+	game.fire_cooldown = 0;
+	game.tick = 0;
+
+	// Bottom centre of the world, on one screen the same spot the old PlayerX/PlayerY globals started at
+	float player_x = (world.min_x + world.max_x) * 0.5f - 0.075f + PLAYER_HALF_SIZE;
+	game.player = game.entities.create(KIND_PLAYER, player_x, world.min_y + 0.1f + PLAYER_HALF_SIZE,
+		0.0f, 0.0f, PLAYER_HALF_SIZE, PLAYER_HALF_SIZE);
+	game.keys.clear();
+	game.camera = game.prev_camera = follow_player(game, player_x);
+	game.particles.recenter(game.camera.x, game.camera.y);
+
+	game.level = level;
+	game.level_start = 0;
+	if (level)
+	{
+		game.next_spawn = level->spawns.data();
+		spawn_from_level(game);
+	}
+	else
+	{
+		spawn_formation(game);
+	}
+}
+
+void game_apply_input(GameState& game, const InputEvent& event)
+{
+	game.keys.apply(event); // Acted on in game_tick, once per tick however often the key repeats
+}
+
+void game_step(GameState& game, InputQueue& inputs, float dt, InputLog* applied)
+{
+	InputEvent event;
+	while (inputs.pop_due(game.tick, event))
+	{
+		game_apply_input(game, event);
+		if (applied)
+		{
+			event.tick = game.tick;
+			applied->append(event);
+		}
+	}
+
+	game_tick(game, dt);
+	game.tick++;
+}
+
+void game_fire(GameState& game)
+{
+	EntityStore& entities = game.entities;
+	if (game.fire_cooldown > 0 || !entities.valid(game.player))
+	{
+		return;
+	}
+
+	std::uint32_t p = entities.slot(game.player);
+	float x = entities.pos_x[p];
+	float y = entities.pos_y[p] + entities.half_h[p];
+
+	if (entities.size() >= MAX_ENTITIES)
+	{
+		return;
+	}
+
+	entities.create(KIND_BULLET, x, y + BULLET_HALF_H, 0.0f, BULLET_SPEED, BULLET_HALF_W, BULLET_HALF_H);
+	game_spawn_effect(game, EFFECT_MUZZLE_FLASH, x, y, 6);
+	game.fire_cooldown = FIRE_COOLDOWN_TICKS;
+}
+
+EntityHandle game_spawn_enemy(GameState& game, float x, float y, float vx, float vy)
+{
+	if (game.entities.size() >= MAX_ENTITIES)
+	{
+		return EntityHandle();
+	}
+
+	EntityHandle handle = game.entities.create(KIND_ENEMY, x, y, vx, vy, ENEMY_HALF_SIZE, ENEMY_HALF_SIZE);
+	game.enemy_grid.insert(handle.index, x, y, ENEMY_HALF_SIZE, ENEMY_HALF_SIZE);
+	return handle;
+}
+
+void game_spawn_effect(GameState& game, EffectKind kind, float x, float y, int lifetime)
+{
+	Effect* effect = game.effects.acquire();
+	if (effect)
+	{
+		effect->kind = kind;
+		effect->x = x;
+		effect->y = y;
+		effect->lifetime = lifetime;
+	}
+}
+
+// Moves enemies that changed cell to their new grid cell. Parked ones cannot have.
+static void update_enemy_grid(GameState& game)
+{
+	EntityStore& entities = game.entities;
+	for (size_t i = 0; i < entities.size(); ++i)
+	{
+		bool moved = entities.pos_x[i] != entities.prev_x[i] || entities.pos_y[i] != entities.prev_y[i];
+		if (entities.kind[i] == KIND_ENEMY && moved)
+		{
+			game.enemy_grid.move(entities.id(static_cast<std::uint32_t>(i)), entities.pos_x[i], entities.pos_y[i]);
+		}
+	}
+}
+
+// Collects the live enemies from the grid cells around a box into the scratch arrays. Only reads
+// the game, so it is safe to call from several threads with different scratch.
+static AabbBatch gather_enemies(const GameState& game, CollisionScratch& scratch, const Aabb& box)
+{
+	const EntityStore& entities = game.entities;
+
+	size_t found = game.enemy_grid.query(box.min_x, box.min_y, box.max_x, box.max_y, scratch.ids.data(), scratch.ids.size());
+
+	size_t n = 0;
+	for (size_t c = 0; c < found; ++c)
+	{
+		std::uint32_t e = entities.slot_of(scratch.ids[c]);
+		if (entities.flags[e] & FLAG_DEAD)
+		{
+			continue;
+		}
+
+		scratch.ids[n] = e;
+		scratch.min_x[n] = entities.pos_x[e] - entities.half_w[e];
+		scratch.min_y[n] = entities.pos_y[e] - entities.half_h[e];
+		scratch.max_x[n] = entities.pos_x[e] + entities.half_w[e];
+		scratch.max_y[n] = entities.pos_y[e] + entities.half_h[e];
+		n++;
+	}
+
+	AabbBatch batch = { scratch.min_x.data(), scratch.min_y.data(), scratch.max_x.data(), scratch.max_y.data(), n };
+	return batch;
+}
+
+static void kill_enemy(GameState& game, std::uint32_t slot)
+{
+	EntityStore& entities = game.entities;
+	entities.flags[slot] |= FLAG_DEAD;
+	game_spawn_effect(game, EFFECT_EXPLOSION, entities.pos_x[slot], entities.pos_y[slot], 30);
+	game.particles.emit(PARTICLE_SPARK, entities.pos_x[slot], entities.pos_y[slot], EXPLOSION_SPARKS, 0.0f, 0.0f, 1.2f, 40);
+}
+
+static const std::uint32_t NO_TARGET = 0xFFFFFFFF;
+
+// First live enemy a bullet overlaps, in grid query order
+static std::uint32_t find_target(const GameState& game, CollisionScratch& scratch, size_t b)
+{
+	const EntityStore& entities = game.entities;
+	if (entities.kind[b] != KIND_BULLET || (entities.flags[b] & FLAG_DEAD))
+	{
+		return NO_TARGET;
+	}
+
+	Aabb box = { entities.pos_x[b] - entities.half_w[b], entities.pos_y[b] - entities.half_h[b],
+		entities.pos_x[b] + entities.half_w[b], entities.pos_y[b] + entities.half_h[b] };
+
+	AabbBatch batch = gather_enemies(game, scratch, box);
+	if (batch.count == 0 || overlap_aabb_batch(box, batch, scratch.hits.data()) == 0)
+	{
+		return NO_TARGET;
+	}
+
+	for (size_t c = 0; c < batch.count; ++c)
+	{
+		if (scratch.hits[c])
+		{
+			return scratch.ids[c];
+		}
+	}
+	return NO_TARGET;
+}
+
+// Splits [0, count) over the job system, or runs it inline without one
+template <typename Fn>
+static void for_range(GameState& game, size_t count, size_t grain, Fn& fn)
+{
+	if (game.jobs)
+	{
+		game.jobs->parallel_for(count, grain, fn);
+	}
+	else
+	{
+		fn(0, count, 0);
+	}
+}
+
+// Tests every bullet against the enemies in the grid cells around it. The queries run in parallel
+// against the state at the start of the phase; kills are then applied in bullet order, and a
+// bullet whose target was already taken by an earlier bullet looks again, exactly like a serial
+// pass would.
+static void collide_bullets(GameState& game)
+{
+	EntityStore& entities = game.entities;
+	std::uint32_t* targets = game.bullet_targets.data();
+
+	auto find_targets = [&game, targets](size_t begin, size_t end, int thread)
+	{
+		for (size_t b = begin; b < end; ++b)
+		{
+			targets[b] = find_target(game, game.scratch[thread], b);
+		}
+	};
+	for_range(game, entities.size(), COLLISION_GRAIN, find_targets);
+
+	// A bullet takes out the first enemy it touches
+	for (size_t b = 0; b < entities.size(); ++b)
+	{
+		std::uint32_t target = targets[b];
+		if (target != NO_TARGET && (entities.flags[target] & FLAG_DEAD))
+		{
+			target = find_target(game, game.scratch[0], b);
+		}
+		if (target != NO_TARGET)
+		{
+			entities.flags[b] |= FLAG_DEAD;
+			kill_enemy(game, target);
+			game.score++;
+		}
+	}
+}
+
+// Enemies touching the player triangle are destroyed and counted as hits on the player
+static void collide_player(GameState& game)
+{
+	EntityStore& entities = game.entities;
+	CollisionScratch& scratch = game.scratch[0];
+	if (!entities.valid(game.player))
+	{
+		return;
+	}
+
+	std::uint32_t p = entities.slot(game.player);
+	float x = entities.pos_x[p];
+	float y = entities.pos_y[p];
+	float hw = entities.half_w[p];
+	float hh = entities.half_h[p];
+
+	// Same corners display_func draws
+	const float tri_x[3] = { x - hw, x + hw, x };
+	const float tri_y[3] = { y - hh, y - hh, y + hh };
+
+	Aabb bounds = { x - hw, y - hh, x + hw, y + hh };
+	AabbBatch batch = gather_enemies(game, scratch, bounds);
+	if (batch.count == 0 || overlap_aabb_batch(bounds, batch, scratch.hits.data()) == 0)
+	{
+		return;
+	}
+
+	for (size_t c = 0; c < batch.count; ++c)
+	{
+		Aabb enemy = { batch.min_x[c], batch.min_y[c], batch.max_x[c], batch.max_y[c] };
+		if (scratch.hits[c] && triangle_overlaps_aabb(tri_x, tri_y, enemy))
+		{
+			kill_enemy(game, scratch.ids[c]);
+			game.player_hits++;
+		}
+	}
+}
+
+// Removes anything that left the world, on any side, or was flagged dead during the tick
+static void remove_dead(GameState& game)
+{
+	EntityStore& entities = game.entities;
+	const float top = game.world.max_y + DESPAWN_MARGIN;
+	const float bottom = game.world.min_y - DESPAWN_MARGIN;
+	const float left = game.world.min_x - DESPAWN_MARGIN;
+	const float right = game.world.max_x + DESPAWN_MARGIN;
+	for (size_t i = entities.size(); i > 0; --i)
+	{
+		std::uint32_t slot = static_cast<std::uint32_t>(i - 1);
+
+		bool off_field = entities.kind[slot] != KIND_PLAYER
+			&& (entities.pos_y[slot] > top || entities.pos_y[slot] < bottom
+				|| entities.pos_x[slot] < left || entities.pos_x[slot] > right);
+
+		if (off_field || (entities.flags[slot] & FLAG_DEAD))
+		{
+			if (entities.kind[slot] == KIND_ENEMY)
+			{
+				game.enemy_grid.remove(entities.id(slot));
+			}
+			entities.destroy_at(slot);
+		}
+	}
+}
+
+void game_tick(GameState& game, float dt)
+{
+	EntityStore& entities = game.entities;
+
+	if (game.fire_cooldown > 0)
+	{
+		game.fire_cooldown--;
+	}
+
+	// Shoots straight up, player still cant move up or down
+	const KeyState& keys = game.keys;
+	if (keys.down('w') || keys.special_down(SPECIAL_UP))
+	{
+		game_fire(game);
+	}
+
+	if (entities.valid(game.player))
+	{
+		float direction = 0.0f;
+		if (keys.down('a') || keys.special_down(SPECIAL_LEFT)) direction -= 1.0f;
+		if (keys.down('d') || keys.special_down(SPECIAL_RIGHT)) direction += 1.0f;
+
+		// Stops at the edge of the world instead of leaving it
+		std::uint32_t p = entities.slot(game.player);
+		float min_x = game.world.min_x + entities.half_w[p];
+		float max_x = game.world.max_x - entities.half_w[p];
+		float x = entities.pos_x[p] + direction * PLAYER_SPEED * dt;
+		if (x > max_x) x = max_x;
+		if (x < min_x) x = min_x;
+		entities.vel_x[p] = (x - entities.pos_x[p]) / dt;
+
+		game.prev_camera = game.camera;
+		game.camera = follow_player(game, x);
+		game.particles.recenter(game.camera.x, game.camera.y);
+
+		// Exhaust trails behind, thicker while moving
+		float exhaust_y = entities.pos_y[p] - entities.half_h[p];
+		game.particles.emit(PARTICLE_EXHAUST, entities.pos_x[p], exhaust_y, direction != 0.0f ? 3 : 1,
+			-0.5f * entities.vel_x[p], -0.6f, 0.15f, 24);
+	}
+	game.keys.end_tick();
+
+	// Everything moves every tick, on screen or not, so the result never depends on the view
+	auto integrate = [&entities, dt](size_t begin, size_t end, int)
+	{
+		entities.update_range(dt, begin, end);
+	};
+	for_range(game, entities.size(), UPDATE_GRAIN, integrate);
+
+	update_enemy_grid(game);
+	collide_bullets(game);
+	collide_player(game);
+	remove_dead(game);
+
+	if (game.level)
+	{
+		spawn_from_level(game);
+	}
+	else if (game.enemy_grid.size() == 0)
+	{
+		spawn_formation(game);
+	}
+
+	game.effects.for_each([&game](Effect& effect)
+	{
+		if (++effect.age >= effect.lifetime)
+		{
+			game.effects.release(&effect);
+		}
+	});
+	game.particles.update();
+}
+
+std::uint64_t game_checksum(const GameState& game)
+{
+	// FNV-1a over the raw bytes of everything that affects the simulation
+	std::uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+	};
+
+	const EntityStore& entities = game.entities;
+	const size_t n = entities.size();
+	mix(&game.tick, sizeof(game.tick));
+	mix(&n, sizeof(n));
+	mix(entities.pos_x.data(), n * sizeof(float));
+	mix(entities.pos_y.data(), n * sizeof(float));
+	mix(entities.vel_x.data(), n * sizeof(float));
+	mix(entities.vel_y.data(), n * sizeof(float));
+	mix(entities.kind.data(), n);
+	mix(&game.fire_cooldown, sizeof(game.fire_cooldown));
+	mix(&game.player_hits, sizeof(game.player_hits));
+	return hash;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "camera.h"
+#include "collision_kernel.h"
+#include "entities.h"
+#include "input.h"
+#include "jobs.h"
+#include "level.h"
+#include "particles.h"
+#include "pool.h"
+#include "spatial_grid.h"
+
+//=================================================================================================
+// GAME STATE
+//
+// Everything the simulation owns. Nothing in here touches GL or GLUT, the callbacks in main.cpp
+// translate input into calls below and draw whatever the entity store contains.
+//=================================================================================================
+
+const float PLAYER_SPEED = 1.5f; // Units per second while a move key is held
+const float PLAYER_HALF_SIZE = 0.05f; // The player triangle is 0.1 wide and 0.1 tall
+
+const float BULLET_SPEED = 2.0f; // Units per second
+const float BULLET_HALF_W = 0.005f;
+const float BULLET_HALF_H = 0.02f;
+const int FIRE_COOLDOWN_TICKS = 12; // 10 shots per second at 120 Hz
+
+const float ENEMY_HALF_SIZE = 0.04f;
+
+const int EXPLOSION_SPARKS = 48; // Particles per destroyed enemy
+
+const size_t MAX_ENTITIES = 16384; // Reserved up front so spawning never reallocates
+const size_t MAX_EFFECTS = 512;
+const size_t MAX_PARTICLES = 131072; // Sparks and exhaust, allocated once in game_init
+const size_t MAX_COLLISION_CANDIDATES = 1024; // Per bullet query
+
+const int GRID_CELLS = 32; // Per axis, over the [-1, 1] play field; larger worlds get more cells of the same size
+const int MAX_GRID_CELLS = 1024; // Per axis
+
+const float DESPAWN_MARGIN = 0.1f; // Enemies and bullets this far past any edge of the world are removed
+
+// Items per job when the tick is split across threads
+const size_t UPDATE_GRAIN = 4096;
+const size_t COLLISION_GRAIN = 256;
+
+enum EffectKind
+{
+	EFFECT_MUZZLE_FLASH,
+	EFFECT_EXPLOSION,
+};
+
+// Purely visual, short-lived and never collides, so it lives in a pool rather than the entity store
+struct Effect
+{
+	EffectKind kind = EFFECT_MUZZLE_FLASH;
+	float x = 0.0f, y = 0.0f;
+	int age = 0; // Ticks since spawn
+	int lifetime = 0; // Ticks until it is released
+};
+
+// Candidate boxes gathered from the grid for the collision kernel, sized once in game_init
+struct CollisionScratch
+{
+	std::vector<std::uint32_t> ids;
+	std::vector<float> min_x, min_y, max_x, max_y;
+	std::vector<std::uint8_t> hits;
+};
+
+struct GameState
+{
+	EntityStore entities;
+	ObjectPool<Effect> effects;
+	ParticleSystem particles; // Drawn only, never collides and is left out of the checksum
+	SpatialGrid enemy_grid; // Every live enemy, indexed by entity id
+	std::vector<CollisionScratch> scratch; // One per job thread, [0] for the serial parts of the tick
+	std::vector<std::uint32_t> bullet_targets; // Per slot, first enemy each bullet overlaps
+	JobSystem* jobs = nullptr; // Splits the tick across threads when set
+	std::uint32_t tick = 0; // Ticks simulated so far, input events are stamped with this
+	EntityHandle player;
+	KeyState keys; // Updated by input events, sampled once per tick
+	int fire_cooldown = 0; // Ticks until the player may fire again
+	int player_hits = 0; // Enemies that rammed the player
+	std::uint32_t score = 0; // Enemies shot down; follows from the kills, so left out of the checksum
+
+	Aabb world = { -1.0f, -1.0f, 1.0f, 1.0f }; // The level's, or one screen without a level
+	Camera camera; // Follows the player; only decides what is drawn
+	Camera prev_camera; // Where it was a tick earlier, for interpolation
+
+	const Level* level = nullptr; // Enemies come from here when set, otherwise from a fixed formation
+	const SpawnEvent* next_spawn = nullptr; // First spawn of the level that has not happened yet
+	std::uint32_t level_start = 0; // Tick the current run through the level began on
+};
+
+// Without a level the game keeps respawning a fixed formation. The level and job system must
+// outlive the game. The result of every tick is the same with or without jobs.
+void game_init(GameState& game, const Level* level = nullptr, JobSystem* jobs = nullptr);
+
+// Applies one key event to the held keys. While held, 'a'/'d' or the arrows move and 'w' or up fires.
+void game_apply_input(GameState& game, const InputEvent& event);
+
+// Applies every queued event that is due, then simulates one tick. When applied is set, each event
+// is also appended to it stamped with the tick it actually took effect on, which can be later than
+// the tick it was queued for if it arrived while the tick was already running.
+void game_step(GameState& game, InputQueue& inputs, float dt, InputLog* applied = nullptr);
+
+// Fires a bullet from the tip of the player triangle if the weapon has cooled down
+void game_fire(GameState& game);
+
+// Spawns an enemy and files it in the enemy grid. Returns an invalid handle when the store is full.
+EntityHandle game_spawn_enemy(GameState& game, float x, float y, float vx, float vy);
+
+// Spawns a visual effect, silently dropped when the pool is full
+void game_spawn_effect(GameState& game, EffectKind kind, float x, float y, int lifetime);
+
+// Advances the game by exactly one fixed tick
+void game_tick(GameState& game, float dt);
+
+// Hash of the simulation state, equal on every machine for the same inputs
+std::uint64_t game_checksum(const GameState& game);
@@ -0,0 +1,36 @@
+#include "game_loop.h"
+
+int FixedTimestep::advance()
+{
+	Clock::time_point now = Clock::now();
+	if (!started)
+	{
+		started = true;
+		last_time = now;
+	}
+
+	accumulator += std::chrono::duration<double>(now - last_time).count();
+	last_time = now;
+
+	int count = 0;
+	while (accumulator >= TICK_DT && count < MAX_TICKS_PER_FRAME)
+	{
+		accumulator -= TICK_DT;
+		count++;
+	}
+
+	// Drop whatever we could not catch up on
+	if (accumulator >= TICK_DT)
+	{
+		accumulator = 0.0;
+	}
+
+	ticks += count;
+	return count;
+}
+
+void FixedTimestep::reset()
+{
+	started = false;
+	accumulator = 0.0;
+}
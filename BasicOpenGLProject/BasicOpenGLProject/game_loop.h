@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+
+//=================================================================================================
+// GAME LOOP TIMING
+//
+// The simulation always advances in fixed ticks (TICK_RATE per second) no matter how often GLUT
+// calls idle_func, and the renderer interpolates between the last two ticks using alpha().
+//=================================================================================================
+
+typedef std::chrono::steady_clock Clock;
+
+const int TICK_RATE = 120;
+const float TICK_DT = 1.0f / TICK_RATE;
+
+class FixedTimestep
+{
+public:
+	static const int MAX_TICKS_PER_FRAME = 8; // Most ticks advance() ever returns at once
+
+	// Feeds real time into the accumulator and returns how many ticks should be simulated now.
+	// Long stalls (debugger, window drag) are clamped so we never spiral trying to catch up.
+	int advance();
+
+	// Forgets the time since the last advance, so a pause is not caught up on afterwards
+	void reset();
+
+	// How far between the previous and the current tick the next frame should be drawn, in [0, 1)
+	float alpha() const { return static_cast<float>(accumulator / TICK_DT); }
+
+	unsigned long long tick_count() const { return ticks; }
+
+private:
+	bool started = false;
+	Clock::time_point last_time;
+	double accumulator = 0.0;
+	unsigned long long ticks = 0;
+};
@@ -0,0 +1,219 @@
+#include "gl_ext.h"
+
+#include <cstdio>
+#include <cstring>
+
+PFN_glGenBuffers    pglGenBuffers = nullptr;
+PFN_glDeleteBuffers pglDeleteBuffers = nullptr;
+PFN_glBindBuffer    pglBindBuffer = nullptr;
+PFN_glBufferData    pglBufferData = nullptr;
+PFN_glBufferSubData pglBufferSubData = nullptr;
+
+PFN_glGenQueries          pglGenQueries = nullptr;
+PFN_glDeleteQueries       pglDeleteQueries = nullptr;
+PFN_glBeginQuery          pglBeginQuery = nullptr;
+PFN_glEndQuery            pglEndQuery = nullptr;
+PFN_glGetQueryObjectiv    pglGetQueryObjectiv = nullptr;
+PFN_glGetQueryObjectui64v pglGetQueryObjectui64v = nullptr;
+
+PFN_glCreateShader            pglCreateShader = nullptr;
+PFN_glShaderSource            pglShaderSource = nullptr;
+PFN_glCompileShader           pglCompileShader = nullptr;
+PFN_glGetShaderiv             pglGetShaderiv = nullptr;
+PFN_glGetShaderInfoLog        pglGetShaderInfoLog = nullptr;
+PFN_glDeleteShader            pglDeleteShader = nullptr;
+PFN_glCreateProgram           pglCreateProgram = nullptr;
+PFN_glAttachShader            pglAttachShader = nullptr;
+PFN_glLinkProgram             pglLinkProgram = nullptr;
+PFN_glGetProgramiv            pglGetProgramiv = nullptr;
+PFN_glGetProgramInfoLog       pglGetProgramInfoLog = nullptr;
+PFN_glUseProgram              pglUseProgram = nullptr;
+PFN_glDeleteProgram           pglDeleteProgram = nullptr;
+PFN_glGetUniformLocation      pglGetUniformLocation = nullptr;
+PFN_glUniform1i               pglUniform1i = nullptr;
+PFN_glVertexAttribPointer     pglVertexAttribPointer = nullptr;
+PFN_glEnableVertexAttribArray pglEnableVertexAttribArray = nullptr;
+PFN_glGenVertexArrays         pglGenVertexArrays = nullptr;
+PFN_glDeleteVertexArrays      pglDeleteVertexArrays = nullptr;
+PFN_glBindVertexArray         pglBindVertexArray = nullptr;
+PFN_glGetUniformBlockIndex    pglGetUniformBlockIndex = nullptr;
+PFN_glUniformBlockBinding     pglUniformBlockBinding = nullptr;
+PFN_glBindBufferBase          pglBindBufferBase = nullptr;
+PFN_glGetStringi              pglGetStringi = nullptr;
+PFN_glDrawArraysInstanced     pglDrawArraysInstanced = nullptr;
+PFN_glVertexAttribDivisor     pglVertexAttribDivisor = nullptr;
+
+PFN_glGenFramebuffers         pglGenFramebuffers = nullptr;
+PFN_glDeleteFramebuffers      pglDeleteFramebuffers = nullptr;
+PFN_glBindFramebuffer         pglBindFramebuffer = nullptr;
+PFN_glCheckFramebufferStatus  pglCheckFramebufferStatus = nullptr;
+PFN_glGenRenderbuffers        pglGenRenderbuffers = nullptr;
+PFN_glDeleteRenderbuffers     pglDeleteRenderbuffers = nullptr;
+PFN_glBindRenderbuffer        pglBindRenderbuffer = nullptr;
+PFN_glRenderbufferStorage     pglRenderbufferStorage = nullptr;
+PFN_glFramebufferRenderbuffer pglFramebufferRenderbuffer = nullptr;
+
+static bool HasVbo = false;
+static bool HasCore = false;
+static bool HasFbo = false;
+static bool HasTimerQuery = false;
+static GLProcLoader Loader = nullptr;
+
+template <typename T>
+static bool load(T& fn, const char* name)
+{
+	fn = reinterpret_cast<T>(Loader(name));
+	return fn != nullptr;
+}
+
+static void* glut_loader(const char* name)
+{
+	return reinterpret_cast<void*>(glutGetProcAddress(name));
+}
+
+bool gl_ext_load(GLProcLoader loader)
+{
+	Loader = loader ? loader : glut_loader;
+
+	HasVbo = load(pglGenBuffers, "glGenBuffers")
+		& load(pglDeleteBuffers, "glDeleteBuffers")
+		& load(pglBindBuffer, "glBindBuffer")
+		& load(pglBufferData, "glBufferData")
+		& load(pglBufferSubData, "glBufferSubData");
+
+	int major, minor;
+	gl_ext_version(major, minor);
+
+	// Extensions have to be listed one by one with glGetStringi on core contexts
+	if (major >= 3)
+	{
+		load(pglGetStringi, "glGetStringi");
+	}
+
+	if (major > 3 || (major == 3 && minor >= 3))
+	{
+		HasCore = HasVbo
+			& load(pglCreateShader, "glCreateShader")
+			& load(pglShaderSource, "glShaderSource")
+			& load(pglCompileShader, "glCompileShader")
+			& load(pglGetShaderiv, "glGetShaderiv")
+			& load(pglGetShaderInfoLog, "glGetShaderInfoLog")
+			& load(pglDeleteShader, "glDeleteShader")
+			& load(pglCreateProgram, "glCreateProgram")
+			& load(pglAttachShader, "glAttachShader")
+			& load(pglLinkProgram, "glLinkProgram")
+			& load(pglGetProgramiv, "glGetProgramiv")
+			& load(pglGetProgramInfoLog, "glGetProgramInfoLog")
+			& load(pglUseProgram, "glUseProgram")
+			& load(pglDeleteProgram, "glDeleteProgram")
+			& load(pglGetUniformLocation, "glGetUniformLocation")
+			& load(pglUniform1i, "glUniform1i")
+			& load(pglVertexAttribPointer, "glVertexAttribPointer")
+			& load(pglEnableVertexAttribArray, "glEnableVertexAttribArray")
+			& load(pglGenVertexArrays, "glGenVertexArrays")
+			& load(pglDeleteVertexArrays, "glDeleteVertexArrays")
+			& load(pglBindVertexArray, "glBindVertexArray")
+			& load(pglGetUniformBlockIndex, "glGetUniformBlockIndex")
+			& load(pglUniformBlockBinding, "glUniformBlockBinding")
+			& load(pglBindBufferBase, "glBindBufferBase")
+			& load(pglDrawArraysInstanced, "glDrawArraysInstanced")
+			& load(pglVertexAttribDivisor, "glVertexAttribDivisor");
+	}
+
+	// Same entry point names in ARB_framebuffer_object, unlike the older EXT version
+	if (major >= 3 || gl_ext_supported("GL_ARB_framebuffer_object"))
+	{
+		HasFbo = load(pglGenFramebuffers, "glGenFramebuffers")
+			& load(pglDeleteFramebuffers, "glDeleteFramebuffers")
+			& load(pglBindFramebuffer, "glBindFramebuffer")
+			& load(pglCheckFramebufferStatus, "glCheckFramebufferStatus")
+			& load(pglGenRenderbuffers, "glGenRenderbuffers")
+			& load(pglDeleteRenderbuffers, "glDeleteRenderbuffers")
+			& load(pglBindRenderbuffer, "glBindRenderbuffer")
+			& load(pglRenderbufferStorage, "glRenderbufferStorage")
+			& load(pglFramebufferRenderbuffer, "glFramebufferRenderbuffer");
+	}
+
+	if (major > 3 || (major == 3 && minor >= 3) || gl_ext_supported("GL_ARB_timer_query"))
+	{
+		HasTimerQuery = load(pglGenQueries, "glGenQueries")
+			& load(pglDeleteQueries, "glDeleteQueries")
+			& load(pglBeginQuery, "glBeginQuery")
+			& load(pglEndQuery, "glEndQuery")
+			& load(pglGetQueryObjectiv, "glGetQueryObjectiv")
+			& load(pglGetQueryObjectui64v, "glGetQueryObjectui64v");
+	}
+
+	return HasVbo;
+}
+
+bool gl_ext_has_vbo()
+{
+	return HasVbo;
+}
+
+bool gl_ext_has_core()
+{
+	return HasCore;
+}
+
+bool gl_ext_has_fbo()
+{
+	return HasFbo;
+}
+
+bool gl_ext_has_timer_query()
+{
+	return HasTimerQuery;
+}
+
+void gl_ext_version(int& major, int& minor)
+{
+	major = 1;
+	minor = 0;
+	const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	if (version)
+	{
+		// Skip prefixes like "OpenGL ES "
+		while (*version && (*version < '0' || *version > '9'))
+		{
+			version++;
+		}
+		std::sscanf(version, "%d.%d", &major, &minor);
+	}
+}
+
+bool gl_ext_supported(const char* name)
+{
+	if (pglGetStringi)
+	{
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i)
+		{
+			const char* extension = reinterpret_cast<const char*>(pglGetStringi(GL_EXTENSIONS, i));
+			if (extension && std::strcmp(extension, name) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+	if (!extensions)
+	{
+		return false;
+	}
+
+	// Match whole words only, GL_EXT_foo must not match GL_EXT_foo_bar
+	const size_t length = std::strlen(name);
+	for (const char* p = std::strstr(extensions, name); p; p = std::strstr(p + 1, name))
+	{
+		if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+		{
+			return true;
+		}
+	}
+	return false;
+}
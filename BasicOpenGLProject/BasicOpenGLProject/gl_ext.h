@@ -0,0 +1,206 @@
+#pragma once
+
+#include <GL/freeglut.h>
+#include <cstddef>
+#include <cstdint>
+
+//=================================================================================================
+// GL EXTENSIONS
+//
+// opengl32.lib on Windows only exports GL 1.1, so everything newer is fetched at runtime through
+// glutGetProcAddress after the window (and its context) has been created. The pointers are
+// prefixed with 'p' so they never collide with prototypes a platform glext.h may declare.
+//=================================================================================================
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_VERSION_1_5
+typedef std::ptrdiff_t GLsizeiptr;
+typedef std::ptrdiff_t GLintptr;
+#endif
+#ifndef GL_VERSION_2_0
+typedef char GLchar;
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER   0x8892
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW    0x88E0
+#endif
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW    0x88E4
+#endif
+#ifndef GL_DYNAMIC_DRAW
+#define GL_DYNAMIC_DRAW   0x88E8
+#endif
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE  0x812F
+#endif
+
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER   0x8B30
+#define GL_VERTEX_SHADER     0x8B31
+#define GL_COMPILE_STATUS    0x8B81
+#define GL_LINK_STATUS       0x8B82
+#define GL_INFO_LOG_LENGTH   0x8B84
+#endif
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER    0x8A11
+#define GL_INVALID_INDEX     0xFFFFFFFFu
+#endif
+#ifndef GL_NUM_EXTENSIONS
+#define GL_NUM_EXTENSIONS    0x821D
+#endif
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER             0x8D40
+#define GL_RENDERBUFFER            0x8D41
+#define GL_FRAMEBUFFER_COMPLETE    0x8CD5
+#define GL_COLOR_ATTACHMENT0       0x8CE0
+#define GL_DEPTH_ATTACHMENT        0x8D00
+#define GL_DEPTH_COMPONENT24       0x81A6
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8                   0x8058
+#endif
+
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT            0x8866
+#define GL_QUERY_RESULT_AVAILABLE  0x8867
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED            0x88BF
+#endif
+
+typedef void (APIENTRY* PFN_glGenBuffers)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRY* PFN_glDeleteBuffers)(GLsizei n, const GLuint* buffers);
+typedef void (APIENTRY* PFN_glBindBuffer)(GLenum target, GLuint buffer);
+typedef void (APIENTRY* PFN_glBufferData)(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+typedef void (APIENTRY* PFN_glBufferSubData)(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+
+// GL 3.3 / ARB_timer_query
+typedef void (APIENTRY* PFN_glGenQueries)(GLsizei n, GLuint* ids);
+typedef void (APIENTRY* PFN_glDeleteQueries)(GLsizei n, const GLuint* ids);
+typedef void (APIENTRY* PFN_glBeginQuery)(GLenum target, GLuint id);
+typedef void (APIENTRY* PFN_glEndQuery)(GLenum target);
+typedef void (APIENTRY* PFN_glGetQueryObjectiv)(GLuint id, GLenum pname, GLint* params);
+typedef void (APIENTRY* PFN_glGetQueryObjectui64v)(GLuint id, GLenum pname, std::uint64_t* params);
+
+// GL 2.0 shaders, GL 3.0 vertex arrays, GL 3.1 uniform buffers
+typedef GLuint (APIENTRY* PFN_glCreateShader)(GLenum type);
+typedef void (APIENTRY* PFN_glShaderSource)(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+typedef void (APIENTRY* PFN_glCompileShader)(GLuint shader);
+typedef void (APIENTRY* PFN_glGetShaderiv)(GLuint shader, GLenum pname, GLint* params);
+typedef void (APIENTRY* PFN_glGetShaderInfoLog)(GLuint shader, GLsizei max_length, GLsizei* length, GLchar* log);
+typedef void (APIENTRY* PFN_glDeleteShader)(GLuint shader);
+typedef GLuint (APIENTRY* PFN_glCreateProgram)();
+typedef void (APIENTRY* PFN_glAttachShader)(GLuint program, GLuint shader);
+typedef void (APIENTRY* PFN_glLinkProgram)(GLuint program);
+typedef void (APIENTRY* PFN_glGetProgramiv)(GLuint program, GLenum pname, GLint* params);
+typedef void (APIENTRY* PFN_glGetProgramInfoLog)(GLuint program, GLsizei max_length, GLsizei* length, GLchar* log);
+typedef void (APIENTRY* PFN_glUseProgram)(GLuint program);
+typedef void (APIENTRY* PFN_glDeleteProgram)(GLuint program);
+typedef GLint (APIENTRY* PFN_glGetUniformLocation)(GLuint program, const GLchar* name);
+typedef void (APIENTRY* PFN_glUniform1i)(GLint location, GLint v0);
+typedef void (APIENTRY* PFN_glVertexAttribPointer)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+typedef void (APIENTRY* PFN_glEnableVertexAttribArray)(GLuint index);
+typedef void (APIENTRY* PFN_glGenVertexArrays)(GLsizei n, GLuint* arrays);
+typedef void (APIENTRY* PFN_glDeleteVertexArrays)(GLsizei n, const GLuint* arrays);
+typedef void (APIENTRY* PFN_glBindVertexArray)(GLuint array);
+typedef GLuint (APIENTRY* PFN_glGetUniformBlockIndex)(GLuint program, const GLchar* name);
+typedef void (APIENTRY* PFN_glUniformBlockBinding)(GLuint program, GLuint block_index, GLuint binding);
+typedef void (APIENTRY* PFN_glBindBufferBase)(GLenum target, GLuint index, GLuint buffer);
+typedef const GLubyte* (APIENTRY* PFN_glGetStringi)(GLenum name, GLuint index);
+typedef void (APIENTRY* PFN_glDrawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei instance_count);
+typedef void (APIENTRY* PFN_glVertexAttribDivisor)(GLuint index, GLuint divisor);
+
+// GL 3.0 / ARB_framebuffer_object
+typedef void (APIENTRY* PFN_glGenFramebuffers)(GLsizei n, GLuint* framebuffers);
+typedef void (APIENTRY* PFN_glDeleteFramebuffers)(GLsizei n, const GLuint* framebuffers);
+typedef void (APIENTRY* PFN_glBindFramebuffer)(GLenum target, GLuint framebuffer);
+typedef GLenum (APIENTRY* PFN_glCheckFramebufferStatus)(GLenum target);
+typedef void (APIENTRY* PFN_glGenRenderbuffers)(GLsizei n, GLuint* renderbuffers);
+typedef void (APIENTRY* PFN_glDeleteRenderbuffers)(GLsizei n, const GLuint* renderbuffers);
+typedef void (APIENTRY* PFN_glBindRenderbuffer)(GLenum target, GLuint renderbuffer);
+typedef void (APIENTRY* PFN_glRenderbufferStorage)(GLenum target, GLenum internal_format, GLsizei width, GLsizei height);
+typedef void (APIENTRY* PFN_glFramebufferRenderbuffer)(GLenum target, GLenum attachment, GLenum renderbuffer_target, GLuint renderbuffer);
+
+extern PFN_glGenBuffers    pglGenBuffers;
+extern PFN_glDeleteBuffers pglDeleteBuffers;
+extern PFN_glBindBuffer    pglBindBuffer;
+extern PFN_glBufferData    pglBufferData;
+extern PFN_glBufferSubData pglBufferSubData;
+
+extern PFN_glGenQueries          pglGenQueries;
+extern PFN_glDeleteQueries       pglDeleteQueries;
+extern PFN_glBeginQuery          pglBeginQuery;
+extern PFN_glEndQuery            pglEndQuery;
+extern PFN_glGetQueryObjectiv    pglGetQueryObjectiv;
+extern PFN_glGetQueryObjectui64v pglGetQueryObjectui64v;
+
+extern PFN_glCreateShader            pglCreateShader;
+extern PFN_glShaderSource            pglShaderSource;
+extern PFN_glCompileShader           pglCompileShader;
+extern PFN_glGetShaderiv             pglGetShaderiv;
+extern PFN_glGetShaderInfoLog        pglGetShaderInfoLog;
+extern PFN_glDeleteShader            pglDeleteShader;
+extern PFN_glCreateProgram           pglCreateProgram;
+extern PFN_glAttachShader            pglAttachShader;
+extern PFN_glLinkProgram             pglLinkProgram;
+extern PFN_glGetProgramiv            pglGetProgramiv;
+extern PFN_glGetProgramInfoLog       pglGetProgramInfoLog;
+extern PFN_glUseProgram              pglUseProgram;
+extern PFN_glDeleteProgram           pglDeleteProgram;
+extern PFN_glGetUniformLocation      pglGetUniformLocation;
+extern PFN_glUniform1i               pglUniform1i;
+extern PFN_glVertexAttribPointer     pglVertexAttribPointer;
+extern PFN_glEnableVertexAttribArray pglEnableVertexAttribArray;
+extern PFN_glGenVertexArrays         pglGenVertexArrays;
+extern PFN_glDeleteVertexArrays      pglDeleteVertexArrays;
+extern PFN_glBindVertexArray         pglBindVertexArray;
+extern PFN_glGetUniformBlockIndex    pglGetUniformBlockIndex;
+extern PFN_glUniformBlockBinding     pglUniformBlockBinding;
+extern PFN_glBindBufferBase          pglBindBufferBase;
+extern PFN_glGetStringi              pglGetStringi;
+extern PFN_glDrawArraysInstanced     pglDrawArraysInstanced;
+extern PFN_glVertexAttribDivisor     pglVertexAttribDivisor;
+
+extern PFN_glGenFramebuffers         pglGenFramebuffers;
+extern PFN_glDeleteFramebuffers      pglDeleteFramebuffers;
+extern PFN_glBindFramebuffer         pglBindFramebuffer;
+extern PFN_glCheckFramebufferStatus  pglCheckFramebufferStatus;
+extern PFN_glGenRenderbuffers        pglGenRenderbuffers;
+extern PFN_glDeleteRenderbuffers     pglDeleteRenderbuffers;
+extern PFN_glBindRenderbuffer        pglBindRenderbuffer;
+extern PFN_glRenderbufferStorage     pglRenderbufferStorage;
+extern PFN_glFramebufferRenderbuffer pglFramebufferRenderbuffer;
+
+typedef void* (*GLProcLoader)(const char* name);
+
+// Must be called with a current context. Returns false if no buffer object entry points were found,
+// in which case callers fall back to client-side vertex arrays. Entry points come from
+// glutGetProcAddress unless another loader is given (eglGetProcAddress for a context GLUT did not
+// create).
+bool gl_ext_load(GLProcLoader loader = nullptr);
+
+// True once gl_ext_load has found the GL 1.5 buffer object functions
+bool gl_ext_has_vbo();
+
+// True if everything the GL 3.3 core path needs (shaders, VAOs, uniform buffers, instancing) was found
+bool gl_ext_has_core();
+
+// True if framebuffer objects can be used (GL 3.0 or ARB_framebuffer_object)
+bool gl_ext_has_fbo();
+
+// True if GL_TIME_ELAPSED queries can be used (GL 3.3 or ARB_timer_query)
+bool gl_ext_has_timer_query();
+
+// Context version parsed from GL_VERSION
+void gl_ext_version(int& major, int& minor);
+
+// Looks the name up in the context's extension list
+bool gl_ext_supported(const char* name);
@@ -0,0 +1,128 @@
+#include "headless.h"
+#include "alloc_tracker.h"
+#include "game.h"
+#include "game_loop.h"
+
+#include <cstdio>
+#include <memory>
+
+// Deterministic stand-in for a player: holds the trigger and sweeps back and forth across the field
+static void autopilot(std::uint32_t tick, InputQueue& inputs, InputLog* recording)
+{
+	InputEvent events[3];
+	int count = 0;
+
+	if (tick == 0)
+	{
+		events[count].type = INPUT_KEY_DOWN;
+		events[count].key = 'w';
+		count++;
+	}
+	if (tick % 240 == 0)
+	{
+		bool going_right = (tick / 240) % 2 == 0;
+		if (tick > 0)
+		{
+			events[count].type = INPUT_KEY_UP;
+			events[count].key = going_right ? 'a' : 'd';
+			count++;
+		}
+		events[count].type = INPUT_KEY_DOWN;
+		events[count].key = going_right ? 'd' : 'a';
+		count++;
+	}
+
+	for (int i = 0; i < count; ++i)
+	{
+		events[i].tick = tick;
+		events[i].time_ms = tick * 1000 / TICK_RATE;
+		inputs.push(events[i]);
+		if (recording)
+		{
+			recording->append(events[i]);
+		}
+	}
+}
+
+int run_headless(const HeadlessOptions& options)
+{
+	InputLog replay;
+	std::unique_ptr<InputPlayback> playback;
+	if (!options.replay_path.empty())
+	{
+		if (!replay.load(options.replay_path))
+		{
+			std::fprintf(stderr, "Could not read input log %s\n", options.replay_path.c_str());
+			return 1;
+		}
+		playback.reset(new InputPlayback(replay));
+	}
+
+	unsigned long long ticks = options.ticks;
+	if (ticks == 0)
+	{
+		ticks = playback ? replay.end_tick : TICK_RATE * 60;
+	}
+
+	InputLog recording;
+	bool record = !options.record_path.empty();
+	if (record)
+	{
+		recording.reserve(static_cast<size_t>(ticks / 240) * 2 + 2);
+	}
+
+	Level level;
+	if (!options.level_path.empty() && !load_level(options.level_path, nullptr, level))
+	{
+		return 1;
+	}
+
+	JobSystem jobs;
+	jobs.init(options.threads);
+
+	GameState game;
+	game_init(game, options.level_path.empty() ? nullptr : &level, &jobs);
+	InputQueue inputs;
+
+	std::uint64_t allocs_before = alloc_count();
+	Clock::time_point start = Clock::now();
+
+	for (unsigned long long i = 0; i < ticks; ++i)
+	{
+		if (playback)
+		{
+			playback->feed(game.tick, inputs);
+		}
+		else
+		{
+			autopilot(game.tick, inputs, record ? &recording : nullptr);
+		}
+		game_step(game, inputs, TICK_DT);
+	}
+
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::uint64_t allocs = alloc_count() - allocs_before;
+	std::uint64_t checksum = game_checksum(game);
+
+	std::printf("Headless: %llu ticks in %.3f s, %.0f ticks/s (%.1fx real time) on %d threads\n",
+		ticks, seconds, ticks / seconds, ticks / seconds / TICK_RATE, jobs.thread_count());
+	std::printf("  entities %zu, effects %zu, particles %zu, score %u, player hits %d, heap allocations %llu\n",
+		game.entities.size(), game.effects.size(), game.particles.size(), game.score, game.player_hits, static_cast<unsigned long long>(allocs));
+	std::printf("  checksum %016llx\n", static_cast<unsigned long long>(checksum));
+
+	if (record && !recording.save(options.record_path, game.tick, checksum))
+	{
+		std::fprintf(stderr, "Could not write input log %s\n", options.record_path.c_str());
+		return 1;
+	}
+
+	if (playback && game.tick == replay.end_tick)
+	{
+		bool match = checksum == replay.checksum;
+		std::printf("  replay %s the recorded state (%016llx)\n", match ? "matches" : "DIVERGED FROM",
+			static_cast<unsigned long long>(replay.checksum));
+		return match ? 0 : 2;
+	}
+
+	return 0;
+}
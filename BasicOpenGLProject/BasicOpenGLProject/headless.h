@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+//=================================================================================================
+// HEADLESS
+//
+// Runs the simulation without GLUT or a GL context, for soak tests and performance regressions on
+// machines without a display.
+//=================================================================================================
+
+struct HeadlessOptions
+{
+	unsigned long long ticks = 0; // 0: one minute of game time, or the whole replay
+	std::string replay_path; // Drive the game from a recorded input log instead of the autopilot
+	std::string record_path; // Save the input that was fed to the game
+	int threads = 0; // Job threads including the main one, 0 = one per core
+	std::string level_path; // Empty: the fixed formation. A replay needs the level it was recorded with.
+};
+
+// Runs the game for the requested number of ticks and prints ticks/second plus a checksum of the
+// final state. Replays are checked against the checksum stored in the log. Returns the exit code.
+int run_headless(const HeadlessOptions& options);
@@ -0,0 +1,266 @@
+#include "image.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+
+bool read_file(const std::string& path, std::vector<unsigned char>& data)
+{
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	data.clear();
+	unsigned char chunk[4096];
+	size_t read;
+	while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+	{
+		data.insert(data.end(), chunk, chunk + read);
+	}
+	std::fclose(file);
+	return true;
+}
+
+bool read_manifest(const std::string& path, std::vector<std::string>& entries)
+{
+	std::vector<unsigned char> data;
+	if (!read_file(path, data))
+	{
+		return false;
+	}
+
+	// Entries are relative to the manifest itself
+	size_t slash = path.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+
+	entries.clear();
+	std::string line;
+	for (size_t i = 0; i <= data.size(); ++i)
+	{
+		char c = i < data.size() ? static_cast<char>(data[i]) : '\n';
+		if (c != '\n')
+		{
+			line += c;
+			continue;
+		}
+
+		while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+		{
+			line.pop_back();
+		}
+		if (!line.empty() && line[0] != '#')
+		{
+			entries.push_back(directory + line);
+		}
+		line.clear();
+	}
+	return true;
+}
+
+// Skips whitespace and # comments, then reads one unsigned decimal number
+static bool read_number(const unsigned char* data, size_t size, size_t& at, int& value)
+{
+	while (at < size)
+	{
+		if (data[at] == '#')
+		{
+			while (at < size && data[at] != '\n')
+			{
+				at++;
+			}
+		}
+		else if (std::isspace(data[at]))
+		{
+			at++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (at == size || !std::isdigit(data[at]))
+	{
+		return false;
+	}
+
+	value = 0;
+	while (at < size && std::isdigit(data[at]))
+	{
+		value = value * 10 + (data[at] - '0');
+		if (value > 65535)
+		{
+			return false;
+		}
+		at++;
+	}
+	return true;
+}
+
+bool decode_ppm(const unsigned char* data, size_t size, Image& image)
+{
+	if (size < 2 || data[0] != 'P' || (data[1] != '3' && data[1] != '6'))
+	{
+		return false;
+	}
+	bool binary = data[1] == '6';
+
+	size_t at = 2;
+	int width, height, max_value;
+	if (!read_number(data, size, at, width) || !read_number(data, size, at, height)
+		|| !read_number(data, size, at, max_value) || width == 0 || height == 0 || max_value != 255)
+	{
+		return false;
+	}
+
+	const size_t pixels = static_cast<size_t>(width) * height;
+	image.width = width;
+	image.height = height;
+	image.rgba.resize(pixels * 4);
+
+	if (binary)
+	{
+		at++; // Exactly one whitespace byte separates the header from the samples
+		if (size - at < pixels * 3)
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < pixels; ++i)
+	{
+		int rgb[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			if (binary)
+			{
+				rgb[c] = data[at++];
+			}
+			else if (!read_number(data, size, at, rgb[c]) || rgb[c] > 255)
+			{
+				return false;
+			}
+		}
+
+		bool key = rgb[0] == 255 && rgb[1] == 0 && rgb[2] == 255;
+		unsigned char* out = &image.rgba[i * 4];
+		out[0] = key ? 0 : static_cast<unsigned char>(rgb[0]);
+		out[1] = key ? 0 : static_cast<unsigned char>(rgb[1]);
+		out[2] = key ? 0 : static_cast<unsigned char>(rgb[2]);
+		out[3] = key ? 0 : 255;
+	}
+	return true;
+}
+
+//=================================================================================================
+// PNG
+//=================================================================================================
+
+static void put_u32_be(std::vector<unsigned char>& out, std::uint32_t v)
+{
+	for (int i = 3; i >= 0; --i)
+	{
+		out.push_back(static_cast<unsigned char>(v >> (i * 8)));
+	}
+}
+
+static std::uint32_t crc32(const unsigned char* data, size_t size, std::uint32_t crc = 0)
+{
+	static std::uint32_t table[256];
+	static bool table_ready = false;
+	if (!table_ready)
+	{
+		for (std::uint32_t n = 0; n < 256; ++n)
+		{
+			std::uint32_t c = n;
+			for (int k = 0; k < 8; ++k)
+			{
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+		table_ready = true;
+	}
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+// Length, type, data, then a CRC over type and data
+static void put_chunk(std::vector<unsigned char>& out, const char type[4], const std::vector<unsigned char>& data)
+{
+	put_u32_be(out, static_cast<std::uint32_t>(data.size()));
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+	put_u32_be(out, crc32(&out[start], out.size() - start));
+}
+
+bool write_png(const std::string& path, const Image& image)
+{
+	if (image.width <= 0 || image.height <= 0)
+	{
+		return false;
+	}
+
+	// Every row starts with filter type 0 (none)
+	const size_t row_size = static_cast<size_t>(image.width) * 4;
+	std::vector<unsigned char> raw;
+	raw.reserve((row_size + 1) * image.height);
+	for (int y = 0; y < image.height; ++y)
+	{
+		raw.push_back(0);
+		const unsigned char* row = &image.rgba[y * row_size];
+		raw.insert(raw.end(), row, row + row_size);
+	}
+
+	// zlib stream of stored blocks, at most 65535 bytes each, then the Adler-32 of the raw data
+	std::vector<unsigned char> zlib = { 0x78, 0x01 };
+	const size_t MAX_BLOCK = 65535;
+	for (size_t at = 0; at < raw.size(); at += MAX_BLOCK)
+	{
+		size_t length = raw.size() - at < MAX_BLOCK ? raw.size() - at : MAX_BLOCK;
+		zlib.push_back(at + length == raw.size() ? 1 : 0); // Final block flag
+		zlib.push_back(static_cast<unsigned char>(length));
+		zlib.push_back(static_cast<unsigned char>(length >> 8));
+		zlib.push_back(static_cast<unsigned char>(~length));
+		zlib.push_back(static_cast<unsigned char>(~length >> 8));
+		zlib.insert(zlib.end(), raw.begin() + at, raw.begin() + at + length);
+	}
+	std::uint32_t a = 1, b = 0;
+	for (unsigned char byte : raw)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	put_u32_be(zlib, (b << 16) | a);
+
+	std::vector<unsigned char> header;
+	put_u32_be(header, static_cast<std::uint32_t>(image.width));
+	put_u32_be(header, static_cast<std::uint32_t>(image.height));
+	header.push_back(8); // Bits per channel
+	header.push_back(6); // RGBA
+	header.push_back(0); // Deflate
+	header.push_back(0); // Adaptive filtering
+	header.push_back(0); // Not interlaced
+
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<unsigned char> out(signature, signature + 8);
+	put_chunk(out, "IHDR", header);
+	put_chunk(out, "IDAT", zlib);
+	put_chunk(out, "IEND", std::vector<unsigned char>());
+
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+	return std::fclose(file) == 0 && ok;
+}
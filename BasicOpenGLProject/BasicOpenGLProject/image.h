@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//=================================================================================================
+// IMAGE
+//
+// 8-bit RGBA images loaded from PPM files (P3 text or P6 binary). PPM has no alpha channel, so
+// pure magenta (255, 0, 255) is treated as transparent. Images can be written back out as PNG for
+// screenshots and golden-image comparisons.
+//=================================================================================================
+
+struct Image
+{
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> rgba; // width * height * 4, top row first
+};
+
+// Reads a whole file into memory, false if it cannot be opened
+bool read_file(const std::string& path, std::vector<unsigned char>& data);
+
+// Reads a list of files, one per line with # comments. The entries are relative to the manifest
+// and come back with its directory prepended.
+bool read_manifest(const std::string& path, std::vector<std::string>& entries);
+
+// Decodes a PPM already in memory, false if it is malformed or not 8 bits per channel
+bool decode_ppm(const unsigned char* data, size_t size, Image& image);
+
+// Writes an RGBA PNG. The image data is stored uncompressed (deflate "stored" blocks), which keeps
+// the writer small and every viewer still reads it.
+bool write_png(const std::string& path, const Image& image);
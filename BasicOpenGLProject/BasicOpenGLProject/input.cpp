@@ -0,0 +1,184 @@
+#include "input.h"
+#include "game_loop.h"
+
+#include <cstdio>
+#include <cstring>
+
+const size_t InputQueue::CAPACITY;
+
+bool InputQueue::push(const InputEvent& event)
+{
+	size_t t = tail.load(std::memory_order_relaxed);
+	size_t next = (t + 1) % CAPACITY;
+	if (next == head.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	events[t] = event;
+	tail.store(next, std::memory_order_release); // Publishes the event written above
+	return true;
+}
+
+bool InputQueue::pop_due(std::uint32_t tick, InputEvent& event)
+{
+	size_t h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire) || events[h].tick > tick)
+	{
+		return false;
+	}
+
+	event = events[h];
+	head.store((h + 1) % CAPACITY, std::memory_order_release); // Slot may be reused from here on
+	return true;
+}
+
+//=================================================================================================
+// KEY STATE
+//=================================================================================================
+
+const unsigned KeyState::SPECIAL;
+const unsigned KeyState::WORDS;
+
+void KeyState::apply(const InputEvent& event)
+{
+	unsigned i = event.key;
+	if (event.type == INPUT_SPECIAL_DOWN || event.type == INPUT_SPECIAL_UP)
+	{
+		i += SPECIAL;
+	}
+	else if (i >= 'A' && i <= 'Z')
+	{
+		i += 'a' - 'A'; // Shift going down between press and release must not leave the key stuck
+	}
+
+	std::uint64_t bit = std::uint64_t(1) << (i % 64);
+	if (event.type == INPUT_KEY_DOWN || event.type == INPUT_SPECIAL_DOWN)
+	{
+		held[i / 64] |= bit;
+		pressed[i / 64] |= bit;
+	}
+	else
+	{
+		held[i / 64] &= ~bit;
+	}
+}
+
+void KeyState::end_tick()
+{
+	std::memset(pressed, 0, sizeof(pressed));
+}
+
+void KeyState::clear()
+{
+	std::memset(held, 0, sizeof(held));
+	std::memset(pressed, 0, sizeof(pressed));
+}
+
+//=================================================================================================
+// LOG FILE
+//=================================================================================================
+
+static const char LOG_MAGIC[4] = { 'I', 'R', 'E', 'C' };
+static const std::uint32_t LOG_VERSION = 2; // 2: keys stay down until their release event
+static const std::uint32_t LOG_TICK_RATE = TICK_RATE; // A log only replays at the rate it was recorded at
+
+static void put_u32(std::vector<unsigned char>& out, std::uint32_t v)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		out.push_back(static_cast<unsigned char>(v >> (i * 8)));
+	}
+}
+
+static std::uint32_t get_u32(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+bool InputLog::save(const std::string& path, std::uint32_t log_end_tick, std::uint64_t log_checksum) const
+{
+	std::vector<unsigned char> out;
+	out.reserve(28 + events.size() * 10);
+
+	out.insert(out.end(), LOG_MAGIC, LOG_MAGIC + 4);
+	put_u32(out, LOG_VERSION);
+	put_u32(out, LOG_TICK_RATE);
+	put_u32(out, static_cast<std::uint32_t>(events.size()));
+	put_u32(out, log_end_tick);
+	put_u32(out, static_cast<std::uint32_t>(log_checksum));
+	put_u32(out, static_cast<std::uint32_t>(log_checksum >> 32));
+
+	for (const InputEvent& event : events)
+	{
+		put_u32(out, event.tick);
+		put_u32(out, event.time_ms);
+		out.push_back(event.type);
+		out.push_back(event.key);
+	}
+
+	FILE* file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+	return std::fclose(file) == 0 && ok;
+}
+
+bool InputLog::load(const std::string& path)
+{
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> data;
+	unsigned char chunk[4096];
+	size_t read;
+	while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+	{
+		data.insert(data.end(), chunk, chunk + read);
+	}
+	std::fclose(file);
+
+	if (data.size() < 28 || std::memcmp(data.data(), LOG_MAGIC, 4) != 0
+		|| get_u32(&data[4]) != LOG_VERSION || get_u32(&data[8]) != LOG_TICK_RATE)
+	{
+		return false;
+	}
+
+	std::uint32_t count = get_u32(&data[12]);
+	if (data.size() != 28 + static_cast<size_t>(count) * 10)
+	{
+		return false;
+	}
+
+	end_tick = get_u32(&data[16]);
+	checksum = get_u32(&data[20]) | (static_cast<std::uint64_t>(get_u32(&data[24])) << 32);
+
+	events.resize(count);
+	const unsigned char* p = &data[28];
+	for (InputEvent& event : events)
+	{
+		event.tick = get_u32(p);
+		event.time_ms = get_u32(p + 4);
+		event.type = p[8];
+		event.key = p[9];
+		p += 10;
+	}
+	return true;
+}
+
+void InputPlayback::feed(std::uint32_t tick, InputQueue& queue)
+{
+	while (next < log.events.size() && log.events[next].tick <= tick)
+	{
+		if (!queue.push(log.events[next]))
+		{
+			return; // Try the rest next tick
+		}
+		next++;
+	}
+}
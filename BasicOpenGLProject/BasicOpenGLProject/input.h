@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//=================================================================================================
+// INPUT
+//
+// GLUT callbacks never touch the game directly. They stamp each key event with the tick it has to
+// be applied before and push it into an InputQueue; the update loop drains the queue tick by tick.
+// The same events can be appended to an InputLog and saved, and replaying that log through the
+// queue reproduces the session exactly.
+//=================================================================================================
+
+enum InputEventType : std::uint8_t
+{
+	INPUT_KEY_DOWN,
+	INPUT_KEY_UP,
+	INPUT_SPECIAL_DOWN, // key is a GLUT_KEY_* code
+	INPUT_SPECIAL_UP,
+};
+
+// Arrow keys as they arrive in INPUT_SPECIAL_* events. Same values as GLUT_KEY_*, so the game
+// can read them without including GLUT.
+enum SpecialKey : std::uint8_t
+{
+	SPECIAL_LEFT = 100,
+	SPECIAL_UP = 101,
+	SPECIAL_RIGHT = 102,
+	SPECIAL_DOWN = 103,
+};
+
+struct InputEvent
+{
+	std::uint32_t tick = 0; // Applied right before this tick is simulated
+	std::uint32_t time_ms = 0; // Wall clock time since startup when it happened, informational only
+	std::uint8_t type = INPUT_KEY_DOWN;
+	std::uint8_t key = 0;
+};
+
+// Which keys are held, rebuilt from the same events the queue carries so a replay sees exactly the
+// same state. The game samples it once per tick instead of acting on every (auto-repeated) press;
+// a key pressed and released between two ticks still counts as down for the next one.
+class KeyState
+{
+public:
+	void apply(const InputEvent& event);
+
+	bool down(std::uint8_t key) const { return down_bit(key); }
+	bool special_down(std::uint8_t key) const { return down_bit(SPECIAL + key); }
+
+	// Forgets presses that were already released, once the tick has sampled them
+	void end_tick();
+
+	void clear();
+
+private:
+	static const unsigned SPECIAL = 256; // Special keys live after the 256 character keys
+	static const unsigned WORDS = 512 / 64;
+
+	static bool test(const std::uint64_t* bits, unsigned i) { return (bits[i / 64] >> (i % 64)) & 1; }
+	bool down_bit(unsigned i) const { return test(held, i) || test(pressed, i); }
+
+	std::uint64_t held[WORDS] = {};
+	std::uint64_t pressed[WORDS] = {}; // Went down since the last end_tick
+};
+
+// Fixed-size ring of events waiting for their tick, pushing never allocates. Safe with one thread
+// pushing and another popping.
+class InputQueue
+{
+public:
+	static const size_t CAPACITY = 256;
+
+	// Drops the event (and returns false) if the queue is full
+	bool push(const InputEvent& event);
+
+	// Pops the oldest event if it is due at or before tick
+	bool pop_due(std::uint32_t tick, InputEvent& event);
+
+	bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+private:
+	InputEvent events[CAPACITY];
+	std::atomic<size_t> head{ 0 }; // Only the popping thread writes this
+	std::atomic<size_t> tail{ 0 }; // Only the pushing thread writes this
+};
+
+// A whole recorded session. Binary layout (little-endian):
+//   "IREC", u32 version, u32 tick rate, u32 event count, u32 end tick, u64 checksum,
+//   then per event: u32 tick, u32 time_ms, u8 type, u8 key
+class InputLog
+{
+public:
+	void reserve(size_t count) { events.reserve(count); }
+	void append(const InputEvent& event) { events.push_back(event); }
+
+	// end_tick and checksum let a replay check it reached the exact same state
+	bool save(const std::string& path, std::uint32_t end_tick, std::uint64_t checksum) const;
+	bool load(const std::string& path);
+
+	std::vector<InputEvent> events;
+	std::uint32_t end_tick = 0;
+	std::uint64_t checksum = 0;
+};
+
+// Feeds a loaded log back into a queue in tick order
+class InputPlayback
+{
+public:
+	explicit InputPlayback(const InputLog& log) : log(log) {}
+
+	// Pushes every event stamped at or before tick
+	void feed(std::uint32_t tick, InputQueue& queue);
+
+	bool finished(std::uint32_t tick) const { return next == log.events.size() && tick >= log.end_tick; }
+
+private:
+	const InputLog& log;
+	size_t next = 0;
+};
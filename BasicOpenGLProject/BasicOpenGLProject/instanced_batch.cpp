@@ -0,0 +1,157 @@
+#include "instanced_batch.h"
+#include "gl_ext.h"
+
+#include <cstddef>
+
+// Unit shapes centred on the origin, scaled by each instance's size
+static const float QUAD_VERTICES[] = {
+	-0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f,
+	-0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f,
+};
+static const float TRIANGLE_VERTICES[] = {
+	-0.5f, -0.5f, 0.5f, -0.5f, 0.0f, 0.5f,
+};
+
+void InstancedBatch::init(SpriteShape shape, size_t max_instances, ShaderCache* shaders, SpriteBatch* fallback)
+{
+	sprite_shape = shape;
+	fallback_batch = fallback;
+
+	if (!shaders)
+	{
+		return;
+	}
+
+	program = shaders->get("sprite_instanced");
+	if (program == 0)
+	{
+		return;
+	}
+	shader_cache = shaders;
+
+	capacity = max_instances;
+	instances.resize(capacity);
+	instance_count = 0;
+
+	const float* vertices = shape == SHAPE_QUAD ? QUAD_VERTICES : TRIANGLE_VERTICES;
+	GLsizeiptr vertices_size = shape == SHAPE_QUAD ? sizeof(QUAD_VERTICES) : sizeof(TRIANGLE_VERTICES);
+	shape_vertices = static_cast<GLsizei>(vertices_size / (2 * sizeof(float)));
+
+	pglGenVertexArrays(1, &vao);
+	pglBindVertexArray(vao);
+
+	// The shape never changes
+	pglGenBuffers(1, &shape_vbo);
+	pglBindBuffer(GL_ARRAY_BUFFER, shape_vbo);
+	pglBufferData(GL_ARRAY_BUFFER, vertices_size, vertices, GL_STATIC_DRAW);
+	pglEnableVertexAttribArray(ATTRIB_POSITION);
+	pglVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+
+	// Per-instance attributes advance once per instance instead of once per vertex
+	const GLsizei stride = sizeof(SpriteInstance);
+	pglGenBuffers(1, &instance_vbo);
+	pglBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+	pglEnableVertexAttribArray(ATTRIB_INSTANCE_OFFSET);
+	pglVertexAttribPointer(ATTRIB_INSTANCE_OFFSET, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(SpriteInstance, x)));
+	pglVertexAttribDivisor(ATTRIB_INSTANCE_OFFSET, 1);
+	pglEnableVertexAttribArray(ATTRIB_INSTANCE_SIZE);
+	pglVertexAttribPointer(ATTRIB_INSTANCE_SIZE, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(SpriteInstance, w)));
+	pglVertexAttribDivisor(ATTRIB_INSTANCE_SIZE, 1);
+	pglEnableVertexAttribArray(ATTRIB_COLOR);
+	pglVertexAttribPointer(ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(SpriteInstance, color)));
+	pglVertexAttribDivisor(ATTRIB_COLOR, 1);
+
+	pglBindVertexArray(0);
+	pglBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstancedBatch::shutdown()
+{
+	if (vao != 0)
+	{
+		pglDeleteVertexArrays(1, &vao);
+		vao = 0;
+	}
+	if (shape_vbo != 0)
+	{
+		pglDeleteBuffers(1, &shape_vbo);
+		shape_vbo = 0;
+	}
+	if (instance_vbo != 0)
+	{
+		pglDeleteBuffers(1, &instance_vbo);
+		instance_vbo = 0;
+	}
+	shader_cache = nullptr;
+	program = 0;
+}
+
+void InstancedBatch::begin()
+{
+	instance_count = 0;
+	frame_stats = BatchStats();
+}
+
+void InstancedBatch::add(float x, float y, float w, float h, Color color)
+{
+	if (program == 0)
+	{
+		if (sprite_shape == SHAPE_QUAD)
+		{
+			fallback_batch->add_quad(x - w * 0.5f, y - h * 0.5f, w, h, color);
+		}
+		else
+		{
+			fallback_batch->add_triangle(x - w * 0.5f, y - h * 0.5f, x + w * 0.5f, y - h * 0.5f, x, y + h * 0.5f, color);
+		}
+		return;
+	}
+
+	// Full: draw what we have rather than growing the array mid-frame
+	if (instance_count == capacity)
+	{
+		flush();
+	}
+	instances[instance_count++] = { x, y, w, h, color };
+}
+
+SpriteInstance* InstancedBatch::reserve(size_t count)
+{
+	if (instance_count + count > capacity)
+	{
+		flush();
+	}
+
+	// The records are already there from init, only the count moves
+	SpriteInstance* first = instances.data() + instance_count;
+	instance_count += count;
+	return first;
+}
+
+void InstancedBatch::flush()
+{
+	if (instance_count == 0)
+	{
+		return;
+	}
+
+	const GLsizei stride = sizeof(SpriteInstance);
+	const GLsizei count = static_cast<GLsizei>(instance_count);
+
+	// Orphan, then upload, so the driver never waits on the previous draw
+	pglBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+	pglBufferData(GL_ARRAY_BUFFER, count * stride, nullptr, GL_STREAM_DRAW);
+	pglBufferSubData(GL_ARRAY_BUFFER, 0, count * stride, instances.data());
+	pglBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	shader_cache->use(program);
+	pglBindVertexArray(vao);
+	pglDrawArraysInstanced(GL_TRIANGLES, 0, shape_vertices, count);
+	pglBindVertexArray(0);
+
+	frame_stats.uploads++;
+	frame_stats.draw_calls++;
+	frame_stats.vertices += shape_vertices * count;
+
+	instance_count = 0;
+}
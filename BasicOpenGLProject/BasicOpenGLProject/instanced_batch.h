@@ -0,0 +1,67 @@
+#pragma once
+
+#include "shaders.h"
+#include "sprite_batch.h"
+
+#include <GL/freeglut.h>
+#include <vector>
+
+//=================================================================================================
+// INSTANCED BATCH
+//
+// Draws many copies of one unit shape with glDrawArraysInstanced. The shape lives in a static
+// vertex buffer; only a small record per instance (centre, size, colour) is streamed each frame,
+// so any number of identical sprites costs one upload and one draw call. Without the GL 3.3 core
+// path every instance is expanded into the fallback SpriteBatch instead.
+//=================================================================================================
+
+enum SpriteShape
+{
+	SHAPE_QUAD,
+	SHAPE_TRIANGLE, // Points up, like the player
+};
+
+struct SpriteInstance
+{
+	float x, y; // Centre
+	float w, h; // Full size
+	Color color;
+};
+
+class InstancedBatch
+{
+public:
+	// shaders == nullptr (legacy path) sends everything through fallback
+	void init(SpriteShape shape, size_t max_instances, ShaderCache* shaders, SpriteBatch* fallback);
+	void shutdown();
+
+	void begin();
+
+	void add(float x, float y, float w, float h, Color color);
+
+	// Appends count records for the caller to fill in, so they can be written from several threads.
+	// count must not exceed max_instances. Only available when instanced() is true.
+	SpriteInstance* reserve(size_t count);
+
+	// One upload and one instanced draw for everything added since the last flush
+	void flush();
+
+	bool instanced() const { return program != 0; }
+	const BatchStats& stats() const { return frame_stats; }
+
+private:
+	SpriteShape sprite_shape = SHAPE_QUAD;
+	GLsizei shape_vertices = 0;
+	std::vector<SpriteInstance> instances; // Sized to capacity once, the first instance_count are this frame's
+	size_t instance_count = 0;
+	size_t capacity = 0;
+
+	GLuint shape_vbo = 0;
+	GLuint instance_vbo = 0;
+	GLuint vao = 0;
+	ShaderCache* shader_cache = nullptr;
+	GLuint program = 0;
+
+	SpriteBatch* fallback_batch = nullptr;
+	BatchStats frame_stats;
+};
@@ -0,0 +1,199 @@
+#include "jobs.h"
+
+const size_t JobSystem::Deque::CAPACITY;
+
+//=================================================================================================
+// DEQUE
+//=================================================================================================
+
+bool JobSystem::Deque::push(const Job& job)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (bottom - top == CAPACITY)
+	{
+		return false;
+	}
+	jobs[bottom % CAPACITY] = job;
+	bottom++;
+	return true;
+}
+
+bool JobSystem::Deque::pop(Job& job)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (bottom == top)
+	{
+		return false;
+	}
+	bottom--;
+	job = jobs[bottom % CAPACITY];
+	return true;
+}
+
+bool JobSystem::Deque::steal(Job& job)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if (bottom == top)
+	{
+		return false;
+	}
+	job = jobs[top % CAPACITY];
+	top++;
+	return true;
+}
+
+//=================================================================================================
+// JOB SYSTEM
+//=================================================================================================
+
+void JobSystem::init(int threads)
+{
+	shutdown();
+
+	if (threads <= 0)
+	{
+		threads = static_cast<int>(std::thread::hardware_concurrency());
+		if (threads <= 0)
+		{
+			threads = 1;
+		}
+	}
+
+	stopping = false;
+	queued = 0;
+	for (int i = 0; i < threads; ++i)
+	{
+		deques.push_back(new Deque());
+	}
+	for (int i = 1; i < threads; ++i)
+	{
+		workers.emplace_back(&JobSystem::worker_main, this, i);
+	}
+}
+
+void JobSystem::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> guard(sleep_lock);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	workers.clear();
+
+	for (Deque* deque : deques)
+	{
+		delete deque;
+	}
+	deques.clear();
+}
+
+void JobSystem::run(size_t count, size_t grain, JobFn fn, void* context)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (grain == 0)
+	{
+		grain = 1;
+	}
+
+	// Nobody to share with, or nothing worth sharing
+	if (deques.size() <= 1 || count <= grain)
+	{
+		for (size_t begin = 0; begin < count; begin += grain)
+		{
+			fn(context, begin, begin + grain < count ? begin + grain : count, 0);
+		}
+		return;
+	}
+
+	// Deal the chunks out so every worker starts on a share of its own. queued goes up before each
+	// push, otherwise a worker still awake from the last run could take the job first and wrap it.
+	std::atomic<size_t> remaining(0);
+	const size_t n = deques.size();
+	size_t target = 0;
+	for (size_t begin = 0; begin < count; begin += grain)
+	{
+		Job job = { fn, context, begin, begin + grain < count ? begin + grain : count, &remaining };
+		remaining++;
+		queued++;
+		if (!deques[target]->push(job))
+		{
+			queued--;
+			execute(job, 0); // Deque full, do it ourselves
+		}
+		target = (target + 1) % n;
+	}
+
+	// Taking the lock orders the pushes before any sleeping worker's next look at queued
+	{
+		std::lock_guard<std::mutex> guard(sleep_lock);
+	}
+	wake.notify_all();
+
+	// Help out until every chunk, including the ones stolen by workers, has finished
+	while (remaining.load(std::memory_order_acquire) > 0)
+	{
+		Job job;
+		if (find_job(0, job))
+		{
+			execute(job, 0);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::find_job(int thread, Job& job)
+{
+	const int n = thread_count();
+	if (deques[thread]->pop(job))
+	{
+		queued--;
+		return true;
+	}
+
+	for (int i = 1; i < n; ++i)
+	{
+		if (deques[(thread + i) % n]->steal(job))
+		{
+			queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::execute(const Job& job, int thread)
+{
+	job.fn(job.context, job.begin, job.end, thread);
+	job.remaining->fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::worker_main(int thread)
+{
+	for (;;)
+	{
+		Job job;
+		if (find_job(thread, job))
+		{
+			execute(job, thread);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(sleep_lock);
+		wake.wait(guard, [this]() { return stopping || queued > 0; });
+		if (stopping)
+		{
+			return;
+		}
+	}
+}
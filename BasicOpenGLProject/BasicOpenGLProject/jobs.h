@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//=================================================================================================
+// JOB SYSTEM
+//
+// A fixed set of worker threads, each with its own deque of jobs. parallel_for deals its chunks
+// out round-robin over all the deques; a thread pops from the bottom of its own deque and, when
+// that runs dry, steals from the top of someone else's, so work spreads out without a shared
+// queue everyone fights over. The thread that calls parallel_for takes part as well (as thread 0),
+// which means a system with no workers simply runs everything inline.
+//
+// Jobs are plain function pointers plus a range, and the deques are fixed-size rings, so
+// submitting work never touches the heap.
+//=================================================================================================
+
+class JobSystem
+{
+public:
+	JobSystem() = default;
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	~JobSystem() { shutdown(); }
+
+	// Total threads including the one submitting work, so 1 means no workers at all. 0 picks one
+	// per core.
+	void init(int threads);
+	void shutdown();
+
+	// Number of threads that may run a job, including the one calling parallel_for
+	int thread_count() const { return static_cast<int>(deques.size()); }
+
+	// Calls fn(begin, end, thread) over [0, count) in chunks of at most grain items and returns
+	// when all of them have run. thread is in [0, thread_count()) and no two chunks running at the
+	// same time share it, so it can index per-thread scratch space. Any thread may submit, but only
+	// one at a time: it runs as thread 0, so two overlapping calls would share its deque and
+	// scratch. It need not be the thread that called init (--sim-thread submits from its own).
+	template <typename Fn>
+	void parallel_for(size_t count, size_t grain, Fn& fn)
+	{
+		run(count, grain, &JobSystem::trampoline<Fn>, &fn);
+	}
+
+private:
+	typedef void (*JobFn)(void* context, size_t begin, size_t end, int thread);
+
+	struct Job
+	{
+		JobFn fn;
+		void* context;
+		size_t begin, end;
+		std::atomic<size_t>* remaining; // Jobs of the same parallel_for still to finish
+	};
+
+	// Owner works at the bottom, thieves take from the top. Short critical sections, so a plain
+	// mutex per deque is enough.
+	struct Deque
+	{
+		static const size_t CAPACITY = 1024;
+
+		std::mutex lock;
+		Job jobs[CAPACITY];
+		size_t top = 0; // Oldest job
+		size_t bottom = 0; // One past the newest job
+
+		bool push(const Job& job);
+		bool pop(Job& job);
+		bool steal(Job& job);
+	};
+
+	template <typename Fn>
+	static void trampoline(void* context, size_t begin, size_t end, int thread)
+	{
+		(*static_cast<Fn*>(context))(begin, end, thread);
+	}
+
+	void run(size_t count, size_t grain, JobFn fn, void* context);
+	bool find_job(int thread, Job& job);
+	void execute(const Job& job, int thread);
+	void worker_main(int thread);
+
+	std::vector<Deque*> deques; // [0] belongs to whichever thread is calling parallel_for
+	std::vector<std::thread> workers;
+
+	std::mutex sleep_lock;
+	std::condition_variable wake;
+	std::atomic<size_t> queued{ 0 }; // Jobs pushed but not yet taken by anyone
+	std::atomic<bool> stopping{ false };
+};
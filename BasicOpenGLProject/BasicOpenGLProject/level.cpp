@@ -0,0 +1,395 @@
+#include "level.h"
+#include "game.h"
+#include "game_loop.h"
+#include "image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+static const size_t MAX_REPORTED_PROBLEMS = 20;
+
+//=================================================================================================
+// COMPILING
+//=================================================================================================
+
+// A repeat block that has not seen its "end" yet
+struct RepeatFrame
+{
+	int line;
+	std::uint32_t count;
+	std::uint32_t every;
+	size_t first_spawn; // Spawns from here on belong to the block
+};
+
+// strtof also takes "nan" and "inf", which would slip past every range check after this
+static bool parse_float(const std::string& token, float& out)
+{
+	char* end;
+	out = std::strtof(token.c_str(), &end);
+	return !token.empty() && *end == '\0' && std::isfinite(out);
+}
+
+static bool parse_uint(const std::string& token, std::uint32_t& out)
+{
+	char* end;
+	unsigned long value = std::strtoul(token.c_str(), &end, 10);
+	out = static_cast<std::uint32_t>(value);
+	return !token.empty() && token[0] != '-' && *end == '\0' && value <= 0xFFFFFFFFul;
+}
+
+static void add_error(std::vector<LevelError>& errors, int line, const std::string& message)
+{
+	errors.push_back({ line, message });
+}
+
+// Parses one non-empty line; false stops compilation
+static bool compile_line(const std::vector<std::string>& tokens, int line, Level& level, std::vector<RepeatFrame>& repeats, std::vector<LevelError>& errors)
+{
+	const std::string& op = tokens[0];
+
+	if (op == "spawn" || op == "row")
+	{
+		bool row = op == "row";
+		size_t required = row ? 6 : 4;
+		if (tokens.size() != required && tokens.size() != required + 2)
+		{
+			add_error(errors, line, row ? "expected: row TICK COUNT X Y SPACING [VX VY]" : "expected: spawn TICK X Y [VX VY]");
+			return true;
+		}
+
+		SpawnEvent event = {};
+		std::uint32_t count = 1;
+		float spacing = 0.0f;
+		size_t at = 1;
+		bool ok = parse_uint(tokens[at++], event.tick);
+		if (row)
+		{
+			ok &= parse_uint(tokens[at++], count);
+		}
+		ok &= parse_float(tokens[at++], event.x);
+		ok &= parse_float(tokens[at++], event.y);
+		if (row)
+		{
+			ok &= parse_float(tokens[at++], spacing);
+		}
+		if (tokens.size() > at)
+		{
+			ok &= parse_float(tokens[at++], event.vx);
+			ok &= parse_float(tokens[at++], event.vy);
+		}
+		if (!ok)
+		{
+			add_error(errors, line, "not a number");
+			return true;
+		}
+
+		if (level.spawns.size() + count > MAX_LEVEL_SPAWNS)
+		{
+			add_error(errors, line, "level has too many spawns");
+			return false;
+		}
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			level.spawns.push_back(event);
+			event.x += spacing;
+		}
+		return true;
+	}
+
+	if (op == "world")
+	{
+		Aabb world;
+		bool ok = tokens.size() == 5 && parse_float(tokens[1], world.min_x) && parse_float(tokens[2], world.min_y)
+			&& parse_float(tokens[3], world.max_x) && parse_float(tokens[4], world.max_y);
+		if (!ok || world.max_x <= world.min_x || world.max_y <= world.min_y)
+		{
+			add_error(errors, line, "expected: world MIN_X MIN_Y MAX_X MAX_Y (MIN < MAX)");
+			return true;
+		}
+		if (world.max_x - world.min_x > MAX_WORLD_SIZE || world.max_y - world.min_y > MAX_WORLD_SIZE)
+		{
+			add_error(errors, line, "world is larger than " + std::to_string(static_cast<int>(MAX_WORLD_SIZE)) + " units across");
+			return true;
+		}
+		level.world = world;
+		return true;
+	}
+
+	if (op == "repeat")
+	{
+		RepeatFrame frame = { line, 0, 0, level.spawns.size() };
+		if (tokens.size() != 3 || !parse_uint(tokens[1], frame.count) || !parse_uint(tokens[2], frame.every) || frame.count == 0)
+		{
+			add_error(errors, line, "expected: repeat COUNT EVERY (COUNT > 0)");
+			frame.count = 1; // Still push it so the matching end does not complain as well
+		}
+		repeats.push_back(frame);
+		return true;
+	}
+
+	if (op == "end")
+	{
+		if (tokens.size() != 1)
+		{
+			add_error(errors, line, "end takes no arguments");
+		}
+		if (repeats.empty())
+		{
+			add_error(errors, line, "end without repeat");
+			return true;
+		}
+
+		RepeatFrame frame = repeats.back();
+		repeats.pop_back();
+
+		// The body (with any inner repeats already expanded) is copied count - 1 more times
+		size_t body = level.spawns.size() - frame.first_spawn;
+		if (body * frame.count > MAX_LEVEL_SPAWNS - frame.first_spawn)
+		{
+			add_error(errors, frame.line, "level has too many spawns");
+			return false;
+		}
+		for (std::uint32_t copy = 1; copy < frame.count; ++copy)
+		{
+			for (size_t i = 0; i < body; ++i)
+			{
+				SpawnEvent event = level.spawns[frame.first_spawn + i];
+				std::uint64_t tick = event.tick + static_cast<std::uint64_t>(copy) * frame.every;
+				if (tick > UINT32_MAX)
+				{
+					add_error(errors, frame.line, "tick out of range");
+					return false;
+				}
+				event.tick = static_cast<std::uint32_t>(tick);
+				level.spawns.push_back(event);
+			}
+		}
+		return true;
+	}
+
+	add_error(errors, line, "unknown directive '" + op + "'");
+	return true;
+}
+
+bool compile_level(const char* text, size_t size, Level& level, std::vector<LevelError>& errors)
+{
+	size_t first_error = errors.size();
+	level.spawns.clear();
+	level.length = 0;
+	level.world = Level().world;
+
+	std::vector<RepeatFrame> repeats;
+	std::vector<std::string> tokens;
+	int line = 0;
+	size_t at = 0;
+	while (at < size)
+	{
+		line++;
+		size_t end = at;
+		while (end < size && text[end] != '\n')
+		{
+			end++;
+		}
+
+		// Everything after a # is a comment
+		std::string content(text + at, end - at);
+		content = content.substr(0, content.find('#'));
+		at = end + 1;
+
+		tokens.clear();
+		std::istringstream words(content);
+		std::string word;
+		while (words >> word)
+		{
+			tokens.push_back(word);
+		}
+
+		if (!tokens.empty() && !compile_line(tokens, line, level, repeats, errors))
+		{
+			break;
+		}
+	}
+
+	for (const RepeatFrame& frame : repeats)
+	{
+		add_error(errors, frame.line, "repeat without end");
+	}
+
+	if (errors.size() != first_error)
+	{
+		level.spawns.clear();
+		return false;
+	}
+
+	// Stable so spawns on the same tick keep the order they were written in
+	std::stable_sort(level.spawns.begin(), level.spawns.end(), [](const SpawnEvent& a, const SpawnEvent& b)
+	{
+		return a.tick < b.tick;
+	});
+	level.length = level.spawns.empty() ? 0 : level.spawns.back().tick + 1;
+	return true;
+}
+
+//=================================================================================================
+// VALIDATION
+//=================================================================================================
+
+bool validate_level(const Level& level, std::vector<LevelError>& problems)
+{
+	size_t first_problem = problems.size();
+	size_t skipped = 0;
+	auto report = [&](const std::string& message)
+	{
+		if (problems.size() - first_problem < MAX_REPORTED_PROBLEMS)
+		{
+			add_error(problems, 0, message);
+		}
+		else
+		{
+			skipped++;
+		}
+	};
+
+	const Aabb& world = level.world;
+	for (const SpawnEvent& event : level.spawns)
+	{
+		if (event.x < world.min_x || event.x > world.max_x || event.y < world.min_y || event.y > world.max_y)
+		{
+			std::ostringstream message;
+			message << "tick " << event.tick << ": spawn at (" << event.x << ", " << event.y << ") is outside the world";
+			report(message.str());
+		}
+	}
+
+	// Spawns are sorted by tick, so stacked enemies are neighbours once x and y break ties
+	std::vector<SpawnEvent> sorted = level.spawns;
+	std::sort(sorted.begin(), sorted.end(), [](const SpawnEvent& a, const SpawnEvent& b)
+	{
+		if (a.tick != b.tick) return a.tick < b.tick;
+		if (a.x != b.x) return a.x < b.x;
+		return a.y < b.y;
+	});
+	for (size_t i = 1; i < sorted.size(); ++i)
+	{
+		const SpawnEvent& a = sorted[i - 1];
+		const SpawnEvent& b = sorted[i];
+		if (a.tick == b.tick && a.x == b.x && a.y == b.y)
+		{
+			std::ostringstream message;
+			message << "tick " << b.tick << ": two enemies spawn on top of each other at (" << b.x << ", " << b.y << ")";
+			report(message.str());
+		}
+	}
+
+	// Enemies live until they leave the world on whichever side they reach first (or forever if
+	// they never move). Sweep over arrivals and departures for the worst case population.
+	auto ticks_to_leave = [](float position, float velocity, float min, float max)
+	{
+		float distance = velocity < 0.0f ? position - (min - DESPAWN_MARGIN) : max + DESPAWN_MARGIN - position;
+		return static_cast<std::uint64_t>(distance / std::abs(velocity) * TICK_RATE) + 1;
+	};
+	std::vector<std::pair<std::uint64_t, int>> changes;
+	changes.reserve(level.spawns.size() * 2);
+	for (const SpawnEvent& event : level.spawns)
+	{
+		changes.push_back({ event.tick, 1 });
+		if (event.vx != 0.0f || event.vy != 0.0f)
+		{
+			std::uint64_t lifetime = UINT64_MAX;
+			if (event.vx != 0.0f)
+			{
+				lifetime = std::min(lifetime, ticks_to_leave(event.x, event.vx, world.min_x, world.max_x));
+			}
+			if (event.vy != 0.0f)
+			{
+				lifetime = std::min(lifetime, ticks_to_leave(event.y, event.vy, world.min_y, world.max_y));
+			}
+			changes.push_back({ event.tick + lifetime, -1 });
+		}
+	}
+	std::sort(changes.begin(), changes.end()); // Departures (-1) sort before arrivals on the same tick
+
+	long long alive = 0;
+	long long peak = 0;
+	std::uint64_t peak_tick = 0;
+	for (const auto& change : changes)
+	{
+		alive += change.second;
+		if (alive > peak)
+		{
+			peak = alive;
+			peak_tick = change.first;
+		}
+	}
+
+	// Leave room for the player and its bullets
+	const long long budget = static_cast<long long>(MAX_ENTITIES) - 256;
+	if (peak > budget)
+	{
+		std::ostringstream message;
+		message << "up to " << peak << " enemies alive around tick " << peak_tick << ", more than the " << budget << " the game can hold";
+		report(message.str());
+	}
+
+	if (skipped > 0)
+	{
+		add_error(problems, 0, "... and " + std::to_string(skipped) + " more");
+	}
+	return problems.size() == first_problem;
+}
+
+//=================================================================================================
+// LOADING
+//=================================================================================================
+
+bool load_level(const std::string& path, const AssetBundle* bundle, Level& level)
+{
+	std::vector<LevelError> errors;
+	bool ok;
+
+	// Straight out of the mapping when the level was packed
+	const BundleEntry* entry = bundle && bundle->is_open() ? bundle->find(path.c_str(), BUNDLE_RAW) : nullptr;
+	if (entry)
+	{
+		ok = compile_level(reinterpret_cast<const char*>(bundle->data(*entry)), entry->size, level, errors);
+	}
+	else
+	{
+		std::vector<unsigned char> text;
+		if (!read_file(path, text))
+		{
+			std::cout << "Could not read level " << path << "\n";
+			return false;
+		}
+		ok = compile_level(reinterpret_cast<const char*>(text.data()), text.size(), level, errors);
+	}
+
+	for (const LevelError& error : errors)
+	{
+		std::cout << path << ":" << error.line << ": " << error.message << "\n";
+	}
+	return ok;
+}
+
+int run_validate_level(const std::string& path)
+{
+	Level level;
+	if (!load_level(path, nullptr, level))
+	{
+		return EXIT_FAILURE;
+	}
+
+	std::vector<LevelError> problems;
+	bool clean = validate_level(level, problems);
+	for (const LevelError& problem : problems)
+	{
+		std::cout << path << ": " << problem.message << "\n";
+	}
+
+	std::cout << path << ": " << level.spawns.size() << " spawns over " << level.length << " ticks, "
+		<< (clean ? "no problems found" : "has problems") << "\n";
+	return clean ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "bundle.h"
+#include "collision_kernel.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//=================================================================================================
+// LEVELS
+//
+// Enemy waves are written as text and compiled into a timeline of spawns sorted by tick. The game
+// keeps a pointer to the next spawn, so finding what spawns on a tick is a compare and a bump.
+//
+//   # comment
+//   world MIN_X MIN_Y MAX_X MAX_Y       bounds of the world, [-1, 1] (one screen) by default
+//   spawn TICK X Y [VX VY]              one enemy
+//   row TICK COUNT X Y SPACING [VX VY]  COUNT enemies left to right from X
+//   repeat COUNT EVERY                  the lines up to the matching "end" run COUNT times,
+//   end                                 each copy EVERY ticks later than the last
+//
+// Ticks are relative to the start of the level, positions are in world units. A world larger than
+// the screen scrolls: the camera follows the player and shows its bottom edge.
+//=================================================================================================
+
+const size_t MAX_LEVEL_SPAWNS = 1 << 20; // Keeps a runaway repeat from eating all memory
+const float MAX_WORLD_SIZE = 64.0f; // Per axis, keeps the enemy grid a sensible size
+
+struct SpawnEvent
+{
+	std::uint32_t tick;
+	float x, y;
+	float vx, vy;
+};
+
+struct Level
+{
+	std::vector<SpawnEvent> spawns; // Sorted by tick
+	std::uint32_t length = 0; // Tick of the last spawn + 1
+	Aabb world = { -1.0f, -1.0f, 1.0f, 1.0f };
+};
+
+struct LevelError
+{
+	int line; // 1-based, 0 if it concerns the whole level
+	std::string message;
+};
+
+// Compiles level text (not necessarily zero-terminated). Syntax errors are appended to errors and
+// make it return false.
+bool compile_level(const char* text, size_t size, Level& level, std::vector<LevelError>& errors);
+
+// Checks a compiled level for things that parse but will not play well: spawns outside the
+// world, enemies stacked on the same spot, or more live enemies than the entity store can hold.
+// Returns true if nothing was found.
+bool validate_level(const Level& level, std::vector<LevelError>& problems);
+
+// Compiles a level from the bundle if it has a raw asset with this path, from the file otherwise.
+// Errors are printed.
+bool load_level(const std::string& path, const AssetBundle* bundle, Level& level);
+
+// --validate-level: compiles and validates a level file, prints what it found and returns the exit
+// code
+int run_validate_level(const std::string& path);
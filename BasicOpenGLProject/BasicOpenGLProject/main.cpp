@@ -1,5 +1,258 @@
 #include <GL/freeglut.h>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "alloc_tracker.h"
+#include "atlas.h"
+#include "benchmarks.h"
+#include "bundle.h"
+#include "game.h"
+#include "game_loop.h"
+#include "gl_ext.h"
+#include "headless.h"
+#include "input.h"
+#include "entity_sprites.h"
+#include "font.h"
+#include "frame_pacing.h"
+#include "instanced_batch.h"
+#include "jobs.h"
+#include "offscreen.h"
+#include "pack_assets.h"
+#include "profiler.h"
+#include "renderer.h"
+#include "snapshot.h"
+#include "sprite_batch.h"
+#include "stress_scene.h"
+#include "trace.h"
+
+Renderer Render; // Shader programs and per-frame uniforms (core) or fixed-function state (legacy)
+RenderPath RequestedPath = RENDER_CORE; // --legacy-gl forces the fixed-function pipeline
+Clock::time_point LaunchTime = Clock::now(); // Set during static initialisation, before main
+bool FirstFrameShown = false;
+
+AssetBundle Bundle; // Mapped for the whole run, assets loaded from it point into the mapping
+SpriteBatch Batch; // Collects everything drawn in a frame into one vertex buffer
+InstancedBatch Instances; // Bullets and enemies: one instanced draw call for all of them
+TextureAtlas Atlas; // Every sprite image packed into one texture
+const AtlasRegion* PlayerSprite = nullptr; // Falls back to a flat triangle without the atlas
+BitmapFont Font; // HUD text, a glyph texture built at startup
+TextRun ScoreText; // Laid out again only when the score changes
+TextRun FpsText; // Changes once a second at most
+int DisplayedFps = 0; // Last figure from update_frame_counter
+int ViewportWidth = 800; // Pixels, HUD text is sized in whole screen pixels
+int ViewportHeight = 600;
+FixedTimestep Timestep; // Turns real time into a whole number of simulation ticks
+FramePacer Pacer; // Caps the frame rate without spinning a core and counts missed frames
+GameState Game; // Player, bullets and enemies
+JobSystem Jobs; // Worker threads for the tick and for building instance buffers
+InputQueue Inputs; // Key events waiting for the tick they apply to
+FrameProfiler Profiler; // CPU time per phase for the last few thousand frames
+GpuTimer GpuTime; // GPU time per frame when timer queries are available
+bool ShowProfiler = false; // F3 toggles the frame time graph
+bool MeasureLatency = false; // --latency: time every key press until a frame shows it
+LatencyMeter Latency;
+TraceWriter Trace; // --trace FILE: frame timeline for chrome://tracing, F9 writes it out
+UtilizationMeter Utilization; // CPU and GPU use while redrawing and while the scene stands still
+
+std::atomic<bool> Paused{ false }; // 'p': no ticks, and no frames once the pause overlay is up
+std::mutex PauseLock; // The sim thread sleeps on PauseChanged while paused
+std::condition_variable PauseChanged;
+bool RedrawPending = true; // Something on screen is out of date: a UI change, a resize, a new snapshot
+bool SceneMoving = true; // The newest snapshot still animates, so every frame drawn from it differs
+bool IdleRunning = true; // While idle_func is unregistered GLUT blocks waiting for events
+bool AlwaysRedraw = false; // --always-redraw: draw on every idle_func like before, for comparison
+
+std::string RecordPath; // Where to save the session's input on exit, empty = not recording
+InputLog Recording;
+InputLog ReplayLog;
+std::unique_ptr<InputPlayback> Playback; // Set when replaying, live input is ignored then
+
+OffscreenTarget Offscreen; // --offscreen N: frames are drawn here at a fixed size and never shown
+int OffscreenFrames = 0; // Frames to render before quitting, 0 = normal windowed run
+int OffscreenFramesDone = 0;
+int OffscreenWidth = 1280;
+int OffscreenHeight = 720;
+std::string OffscreenDumpPath; // --offscreen-dump FILE: the last frame as a PNG
+Clock::time_point OffscreenStart;
+
+std::string LevelPath; // --level FILE, empty = the fixed formation
+Level CurrentLevel;
+
+size_t StressCount = 0; // --stress N: draw N sprites instead of playing, 0 = normal game
+StressScene Stress;
+
+SnapshotBuffer Snapshots; // The simulation publishes, display_func draws whatever is newest
+std::thread SimThread; // --sim-thread: ticks run here while the GLUT thread renders
+std::atomic<bool> SimStop{ false };
+std::atomic<bool> SimFinished{ false }; // A replay ran out of input on the sim thread
+std::atomic<std::uint32_t> SimTick{ 0 }; // Tick the next input event applies to
+
+//=================================================================================================
+// INPUT
+//=================================================================================================
+
+static_assert(SPECIAL_LEFT == GLUT_KEY_LEFT && SPECIAL_UP == GLUT_KEY_UP
+	&& SPECIAL_RIGHT == GLUT_KEY_RIGHT && SPECIAL_DOWN == GLUT_KEY_DOWN, "SpecialKey must match GLUT_KEY_*");
+
+// Stamps a key event with the next tick and queues it for the simulation, which records it once applied
+void queue_input(InputEventType type, int key)
+{
+	ScopedPhase phase(Profiler, PHASE_INPUT);
+
+	if (Playback)
+	{
+		return;
+	}
+
+	InputEvent event;
+	event.tick = SimTick.load(std::memory_order_acquire);
+	event.time_ms = static_cast<std::uint32_t>(glutGet(GLUT_ELAPSED_TIME));
+	event.type = type;
+	event.key = static_cast<std::uint8_t>(key);
+
+	if (MeasureLatency && (type == INPUT_KEY_DOWN || type == INPUT_SPECIAL_DOWN))
+	{
+		Latency.key_pressed(event.tick, Clock::now());
+	}
+
+	Inputs.push(event);
+}
+
+// Saves the recording, or reports whether a finished replay reached the recorded state
+void finish_session()
+{
+	std::uint64_t checksum = game_checksum(Game);
+
+	if (!RecordPath.empty())
+	{
+		if (Recording.save(RecordPath, Game.tick, checksum))
+		{
+			std::cout << "Recorded " << Recording.events.size() << " input events over " << Game.tick << " ticks to " << RecordPath << "\n";
+		}
+		else
+		{
+			std::cout << "Could not write input log " << RecordPath << "\n";
+		}
+	}
+
+	if (Playback && Game.tick == ReplayLog.end_tick)
+	{
+		std::cout << "Replay " << (checksum == ReplayLog.checksum ? "matches" : "DIVERGED FROM") << " the recorded state\n";
+	}
+}
+
+//=================================================================================================
+// SIMULATION
+//=================================================================================================
+
+// A tick applies at most a queue's worth of events, so this much spare room lets a whole batch of
+// ticks record into the log without it growing inside their AllocationGuard
+const size_t RECORD_HEADROOM = InputQueue::CAPACITY * FixedTimestep::MAX_TICKS_PER_FRAME;
+
+// Grows the recording ahead of the next batch of ticks, outside the allocation-free region
+void reserve_recording()
+{
+	if (!RecordPath.empty() && Recording.events.capacity() - Recording.events.size() < RECORD_HEADROOM)
+	{
+		Recording.reserve(Recording.events.capacity() * 2 + RECORD_HEADROOM);
+	}
+}
+
+// Runs ticks simulation steps. Returns false once a replay has run out of recorded input.
+bool run_ticks(int ticks)
+{
+	for (int i = 0; i < ticks; ++i)
+	{
+		if (StressCount > 0)
+		{
+			Stress.update(TICK_DT, &Jobs);
+			continue;
+		}
+		if (Playback)
+		{
+			if (Playback->finished(Game.tick))
+			{
+				return false;
+			}
+			Playback->feed(Game.tick, Inputs);
+		}
+		TraceScope span(Trace, "game_step");
+		// Recorded on the tick the event was applied, which with --sim-thread can be a tick after
+		// the one it was stamped with
+		game_step(Game, Inputs, TICK_DT, RecordPath.empty() ? nullptr : &Recording);
+		SimTick.store(Game.tick, std::memory_order_release);
+	}
+	return true;
+}
+
+// Copies what the renderer needs out of the live state and hands it over. Returns false when every
+// frame drawn from it will look exactly like the last frame drawn from the previous one.
+bool publish_snapshot()
+{
+	static size_t last_count = 0;
+	static bool last_still = false;
+
+	RenderSnapshot& snapshot = Snapshots.write_slot();
+	if (StressCount > 0)
+	{
+		capture_snapshot(snapshot, Stress.entities, nullptr, nullptr, nullptr, nullptr, static_cast<std::uint32_t>(Timestep.tick_count()), Timestep.alpha());
+	}
+	else
+	{
+		capture_snapshot(snapshot, Game.entities, &Game.effects, &Game.particles, &Game.camera, &Game.prev_camera, Game.tick, Timestep.alpha());
+		snapshot.score = Game.score;
+		snapshot.player_hits = Game.player_hits;
+	}
+
+	// Entities can appear or vanish without anything moving, and the last moving snapshot may have
+	// been drawn part way between two ticks
+	bool changed = !snapshot.still || !last_still || snapshot.entities.size() != last_count;
+	last_count = snapshot.entities.size();
+	last_still = snapshot.still;
+
+	Snapshots.publish();
+	return changed;
+}
+
+// --sim-thread: simulates tick N+1 while the GLUT thread is still drawing frame N
+void sim_thread_main()
+{
+	while (!SimStop.load(std::memory_order_relaxed))
+	{
+		if (Paused.load(std::memory_order_acquire))
+		{
+			std::unique_lock<std::mutex> lock(PauseLock);
+			PauseChanged.wait(lock, []() { return !Paused.load() || SimStop.load(); });
+			Timestep.reset(); // The time spent paused is not simulated
+			continue;
+		}
+
+		int ticks = Timestep.advance();
+		if (ticks > 0)
+		{
+			reserve_recording();
+			AllocationGuard guard; // Steady-state ticks must not touch the heap
+			if (!run_ticks(ticks))
+			{
+				SimFinished.store(true, std::memory_order_release);
+				return;
+			}
+			publish_snapshot();
+		}
+
+		// Nothing to do until the next tick is due
+		std::this_thread::sleep_for(std::chrono::duration<float>((1.0f - Timestep.alpha()) * TICK_DT));
+	}
+}
 
 //=================================================================================================
 // CALLBACKS
@@ -11,57 +264,217 @@
 // http://freeglut.sourceforge.net/docs/api.php#WindowCallback
 //-----------------------------------------------------------------------------
 
+// Reports the offscreen rate and saves the last frame if asked. Runs outside display_func because
+// reading the frame back allocates.
+void finish_offscreen()
+{
+	glFinish();
+	double seconds = std::chrono::duration<double>(Clock::now() - OffscreenStart).count();
+	std::printf("Offscreen: %d frames at %dx%d in %.3f s, %.1f frames/s\n", OffscreenFramesDone,
+		Offscreen.width(), Offscreen.height(), seconds, OffscreenFramesDone / seconds);
+
+	if (!OffscreenDumpPath.empty())
+	{
+		Image frame;
+		Offscreen.read_pixels(frame);
+		if (write_png(OffscreenDumpPath, frame))
+		{
+			std::printf("Wrote the last frame to %s\n", OffscreenDumpPath.c_str());
+		}
+		else
+		{
+			std::printf("Could not write %s\n", OffscreenDumpPath.c_str());
+		}
+	}
+}
+
+void idle_func();
+
+// Brings idle_func back after stop_idle
+void start_idle()
+{
+	if (!IdleRunning)
+	{
+		IdleRunning = true;
+		glutIdleFunc(idle_func);
+	}
+}
+
+void wake_timer(int)
+{
+	start_idle();
+}
+
+// Unregisters idle_func so GLUT blocks in its event loop instead of spinning. While paused only an
+// event brings it back; otherwise a timer does when the next tick is due.
+void stop_idle()
+{
+	IdleRunning = false;
+	glutIdleFunc(nullptr);
+	Pacer.skip_gap();
+
+	if (!Paused && !SimThread.joinable())
+	{
+		unsigned int ms = static_cast<unsigned int>(std::ceil((1.0f - Timestep.alpha()) * TICK_DT * 1000.0f));
+		glutTimerFunc(ms > 0 ? ms : 1, wake_timer, 0);
+	}
+}
+
+// Schedules a frame for something that changed outside the simulation
+void request_redraw()
+{
+	RedrawPending = true;
+	glutPostRedisplay();
+}
+
+// 'p': stops the simulation where it is. After the frame that shows the pause overlay nothing
+// changes, so nothing is drawn until the next event.
+void toggle_pause()
+{
+	{
+		std::lock_guard<std::mutex> lock(PauseLock);
+		Paused = !Paused;
+	}
+	PauseChanged.notify_all();
+
+	if (!Paused && !SimThread.joinable())
+	{
+		Timestep.reset(); // The time spent paused is not simulated
+	}
+	request_redraw();
+	start_idle();
+}
+
 void idle_func()
 {
-	//uncomment below to repeatedly draw new frames
+	// Offscreen runs advance exactly one tick per frame, so the same frame count always renders
+	// the same picture no matter how fast the machine is
+	if (OffscreenFrames > 0)
+	{
+		if (OffscreenFramesDone >= OffscreenFrames || !run_ticks(1))
+		{
+			finish_offscreen();
+			glutLeaveMainLoop();
+			return;
+		}
+		publish_snapshot();
+		glutPostRedisplay();
+		return;
+	}
+
+	// The pause overlay is up, wait for a key
+	if (Paused && !RedrawPending && !AlwaysRedraw)
+	{
+		Utilization.set_still(true);
+		stop_idle();
+		return;
+	}
+
+	Pacer.wait();
+
+	// The sim thread does its own ticking, this thread only draws. Only a pause stops the redraws,
+	// a still scene is not noticed here.
+	if (SimThread.joinable())
+	{
+		if (SimFinished.load(std::memory_order_acquire))
+		{
+			glutLeaveMainLoop();
+			return;
+		}
+		Utilization.set_still(false);
+		glutPostRedisplay();
+		return;
+	}
+
+	int ticks = Paused ? 0 : Timestep.advance();
+	if (ticks > 0)
+	{
+		ScopedPhase phase(Profiler, PHASE_UPDATE);
+		reserve_recording();
+		AllocationGuard guard; // Steady-state ticks must not touch the heap
+		if (!run_ticks(ticks))
+		{
+			glutLeaveMainLoop();
+			return;
+		}
+		SceneMoving = publish_snapshot();
+	}
+
+	if (SceneMoving || AlwaysRedraw)
+	{
+		RedrawPending = true;
+	}
+	Utilization.set_still(!RedrawPending);
+	if (!RedrawPending)
+	{
+		stop_idle(); // Nothing would look different before the next tick
+		return;
+	}
+
 	glutPostRedisplay();
 }
 
 void reshape_func(int width, int height)
 {
 	glViewport(0, 0, width, height);
+	ViewportWidth = width > 0 ? width : 1;
+	ViewportHeight = height > 0 ? height : 1;
 	glutPostRedisplay();
 }
 
-float PlayerX = 0.25f; // Establishes intitial value for PlayerX
-float PlayerY = 0.25f; // Establishes intitial value for PlayerY
-
 void keyboard_func(unsigned char key, int x, int y)
 {
 	switch (key)
 	{
-	case 'w':
-
-		//PlayerY += 0.05f; Removed so Player cant move up
-		break;
-	case 'a':
-		PlayerX -= 0.05f; // Moves player left
-		break;
-	case 's':
-		//PlayerY -= 0.05f; Removed so Player cant move down
-		break;
-	case 'd':
-		PlayerX += 0.05f; // Moves player right
-		break;
 		// Exit on escape key press
 	case '\x1B':
-		exit(EXIT_SUCCESS);
+		glutLeaveMainLoop();
+		break;
+	case 'p':
+	case 'P':
+		toggle_pause();
+		break;
+	default:
+		queue_input(INPUT_KEY_DOWN, key); // Game keys are applied by game_apply_input
 		break;
 	}
-
-	glutPostRedisplay();
 }
 
 void key_released(unsigned char key, int x, int y)
 {
+	if (key == 'p' || key == 'P')
+	{
+		return;
+	}
+
+	queue_input(INPUT_KEY_UP, key);
 }
 
 void key_special_pressed(int key, int x, int y)
 {
+	if (key == GLUT_KEY_F3)
+	{
+		ShowProfiler = !ShowProfiler;
+		request_redraw();
+		return;
+	}
+	if (key == GLUT_KEY_F9)
+	{
+		Trace.flush();
+		return;
+	}
+
+	queue_input(INPUT_SPECIAL_DOWN, key);
 }
 
 void key_special_released(int key, int x, int y)
 {
+	if (key == GLUT_KEY_F3 || key == GLUT_KEY_F9)
+	{
+		return;
+	}
+
+	queue_input(INPUT_SPECIAL_UP, key);
 }
 
 void mouse_func(int button, int state, int x, int y)
@@ -80,10 +493,251 @@ void active_motion_func(int x, int y)
 // RENDERING  (creating and displaying the triangle)
 //=================================================================================================
 
+// Shows fps, draw calls, vertices per frame and heap allocations in the window title, refreshed once a second
+void update_frame_counter(const BatchStats& stats)
+{
+	static int frames = 0;
+	static int last_time = glutGet(GLUT_ELAPSED_TIME);
+	static std::uint64_t last_allocs = alloc_count();
+
+	frames++;
+	int now = glutGet(GLUT_ELAPSED_TIME);
+	if (now - last_time < 1000)
+	{
+		return;
+	}
+
+	std::uint64_t allocs = alloc_count();
+	DisplayedFps = frames * 1000 / (now - last_time);
+
+	char title[192];
+	std::snprintf(title, sizeof(title), "Basic OpenGL Example | %d fps | %u draw calls | %u vertices | %llu allocs/s | %llu missed frames",
+		frames * 1000 / (now - last_time), stats.draw_calls, stats.vertices,
+		static_cast<unsigned long long>(allocs - last_allocs), static_cast<unsigned long long>(Pacer.stats().missed));
+	glutSetWindowTitle(title);
+
+	if (StressCount > 0)
+	{
+		std::printf("%zu sprites: %d fps, %u draw calls\n", StressCount, frames * 1000 / (now - last_time), stats.draw_calls);
+	}
+
+	frames = 0;
+	last_time = now;
+	last_allocs = allocs;
+}
+
+// The player goes into the batch; bullets and enemies are all the same quad so they are streamed
+// as instances, built in parallel straight from the entity arrays. With --sim-thread the job system
+// belongs to the simulation, so the instances are built on this thread alone.
+void draw_entities(const EntityStore& entities, float alpha)
+{
+	const size_t n = entities.size();
+	if (Instances.instanced())
+	{
+		build_entity_instances(entities, alpha, Instances.reserve(n), SimThread.joinable() ? nullptr : &Jobs);
+	}
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (entities.kind[i] != KIND_PLAYER && Instances.instanced())
+		{
+			continue;
+		}
+
+		// Draw between the last two ticks so motion stays smooth at any frame rate
+		float x = entities.prev_x[i] + (entities.pos_x[i] - entities.prev_x[i]) * alpha;
+		float y = entities.prev_y[i] + (entities.pos_y[i] - entities.prev_y[i]) * alpha;
+		float hw = entities.half_w[i];
+		float hh = entities.half_h[i];
+
+		switch (entities.kind[i])
+		{
+		case KIND_PLAYER:
+			if (PlayerSprite)
+			{
+				Material material;
+				material.texture = Atlas.texture();
+				Batch.add_sprite(x - hw, y - hh, hw * 2.0f, hh * 2.0f, PlayerSprite->uv, ENTITY_COLORS[KIND_PLAYER], material);
+				break;
+			}
+			Batch.add_triangle(x - hw, y - hh, // 1st vertex
+				x + hw, y - hh, // 2nd vertex
+				x, y + hh, // 3rd vertex (temp)
+				ENTITY_COLORS[KIND_PLAYER]);
+			break;
+		case KIND_BULLET:
+		case KIND_ENEMY:
+			Instances.add(x, y, hw * 2.0f, hh * 2.0f, ENTITY_COLORS[entities.kind[i]]);
+			break;
+		}
+	}
+}
+
+// Every particle is a quad, so they go through the instanced batch with bullets and enemies. The
+// legacy path builds them a chunk at a time and expands them into the sprite batch.
+void draw_particles(const ParticleSystem& particles, float alpha)
+{
+	const size_t n = particles.size();
+	if (Instances.instanced())
+	{
+		build_particle_instances(particles, 0, n, alpha, Instances.reserve(n));
+		return;
+	}
+
+	const size_t CHUNK = 256;
+	SpriteInstance chunk[CHUNK];
+	for (size_t begin = 0; begin < n; begin += CHUNK)
+	{
+		size_t end = begin + CHUNK < n ? begin + CHUNK : n;
+		build_particle_instances(particles, begin, end, alpha, chunk);
+		for (size_t i = 0; i < end - begin; ++i)
+		{
+			Instances.add(chunk[i].x, chunk[i].y, chunk[i].w, chunk[i].h, chunk[i].color);
+		}
+	}
+}
+
+// Muzzle flashes and explosions grow and fade over their lifetime
+void draw_effects(const Effect* effects, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Effect& effect = effects[i];
+		float t = static_cast<float>(effect.age) / effect.lifetime;
+		unsigned char alpha = static_cast<unsigned char>(255.0f * (1.0f - t));
+
+		float size;
+		Color color;
+		if (effect.kind == EFFECT_MUZZLE_FLASH)
+		{
+			size = 0.01f + 0.02f * t;
+			color = { 255, 255, 192, alpha };
+		}
+		else
+		{
+			size = 0.02f + 0.08f * t;
+			color = { 255, 128, 32, alpha };
+		}
+
+		Batch.add_quad(effect.x - size, effect.y - size, size * 2.0f, size * 2.0f, color);
+	}
+}
+
+// Stacked bars of the last frames along the bottom of the screen, one colour per phase, with
+// lines at 60 and 30 fps. GPU time is drawn as a thin bar to the right of each frame.
+void draw_profiler_overlay()
+{
+	const size_t FRAMES = 240;
+	static FrameSample samples[FRAMES];
+	size_t count = Profiler.recent(samples, FRAMES);
+
+	const float left = -0.98f;
+	const float bottom = -0.98f;
+	const float bar_w = 1.2f / FRAMES;
+	const float ms_h = 0.4f / 33.3f; // 30 fps reaches the top of the graph
+
+	const Color phase_colors[PHASE_COUNT] = {
+		{ 64, 160, 255, 200 }, // input
+		{ 64, 220, 96, 200 }, // update
+		{ 255, 196, 64, 200 }, // render
+		{ 200, 96, 255, 200 }, // swap
+	};
+	const Color gpu_color = { 255, 64, 64, 200 };
+	const Color line_color = { 255, 255, 255, 96 };
+
+	Batch.add_quad(left, bottom, bar_w * FRAMES, 0.4f, { 0, 0, 0, 128 });
+	Batch.add_quad(left, bottom + 16.7f * ms_h, bar_w * FRAMES, 0.003f, line_color);
+	Batch.add_quad(left, bottom + 33.3f * ms_h, bar_w * FRAMES, 0.003f, line_color);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		float x = left + i * bar_w;
+		float y = bottom;
+		for (int phase = 0; phase < PHASE_COUNT; ++phase)
+		{
+			float h = samples[i].phase_ms[phase] * ms_h;
+			Batch.add_quad(x, y, bar_w * 0.7f, h, phase_colors[phase]);
+			y += h;
+		}
+
+		if (samples[i].gpu_ms >= 0.0f)
+		{
+			Batch.add_quad(x + bar_w * 0.7f, bottom, bar_w * 0.3f, samples[i].gpu_ms * ms_h, gpu_color);
+		}
+	}
+}
+
+// Score and hits in the top-left corner, the frame rate in the top-right. The text only changes
+// now and then, so most frames just copy the cached quads into the batch.
+void draw_hud(const RenderSnapshot& snapshot)
+{
+	const float HUD_SCALE = 2.0f; // Screen pixels per font pixel
+	const float pixel_w = HUD_SCALE * 2.0f / ViewportWidth;
+	const float pixel_h = HUD_SCALE * 2.0f / ViewportHeight;
+	const float margin_w = 4.0f * pixel_w;
+	const float margin_h = 4.0f * pixel_h;
+	const Color text_color = { 255, 255, 255, 220 };
+
+	char text[64];
+	if (StressCount == 0)
+	{
+		std::snprintf(text, sizeof(text), "SCORE %u\nHITS %d", snapshot.score, snapshot.player_hits);
+		ScoreText.set(text, -1.0f + margin_w, 1.0f - margin_h, pixel_w, pixel_h, text_color);
+		ScoreText.draw(Batch);
+	}
+
+	// Offscreen frames have to come out the same on every run
+	if (!Offscreen.valid())
+	{
+		int length = std::snprintf(text, sizeof(text), "%d FPS", DisplayedFps);
+		float width = (length * GLYPH_ADVANCE - 1) * pixel_w;
+		FpsText.set(text, 1.0f - margin_w - width, 1.0f - margin_h, pixel_w, pixel_h, text_color);
+		FpsText.draw(Batch);
+	}
+}
+
+// Dims the scene and draws a pause sign in the middle
+void draw_pause_overlay()
+{
+	const Color shade = { 0, 0, 0, 160 };
+	const Color sign = { 255, 255, 255, 220 };
+	Batch.add_quad(-1.0f, -1.0f, 2.0f, 2.0f, shade);
+	Batch.add_quad(-0.06f, -0.1f, 0.04f, 0.2f, sign);
+	Batch.add_quad(0.02f, -0.1f, 0.04f, 0.2f, sign);
+}
+
 void display_func(void)
 {
+	AllocationGuard guard; // Steady-state frames must not touch the heap
+	RedrawPending = false;
+
+	Clock::time_point render_start = Clock::now();
+	GpuTime.begin();
+
+	// Only ever the newest published snapshot, never the live state the simulation may be changing
+	const RenderSnapshot& snapshot = Snapshots.acquire();
+
+	if (Offscreen.valid())
+	{
+		if (OffscreenFramesDone == 0)
+		{
+			OffscreenStart = render_start;
+		}
+		Offscreen.bind();
+	}
+
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	// The world through the camera, placed between the last two ticks like everything else.
+	// Offscreen frames go by simulation time so they come out the same on every run.
+	float alpha = Offscreen.valid() ? 1.0f : snapshot_alpha(snapshot, render_start);
+	Aabb view = camera_view(camera_lerp(snapshot.prev_camera, snapshot.camera, alpha));
+	FrameUniforms uniforms;
+	matrix_ortho(view.min_x, view.max_x, view.min_y, view.max_y, uniforms.view_proj);
+	uniforms.time[0] = Offscreen.valid() ? snapshot.tick * TICK_DT : glutGet(GLUT_ELAPSED_TIME) * 0.001f;
+	uniforms.time[1] = uniforms.time[2] = uniforms.time[3] = 0.0f;
+	Render.begin_frame(uniforms);
+
 	// glBegin(GL_LINES);
 	// 	glColor3f(1.0f, 0.0f, 0.0f);
 	// 	glVertex2f(-0.5f, 0.0f);
@@ -97,21 +751,69 @@ void display_func(void)
 	// 	glVertex2f(0.0f, 0.5f);
 	// glEnd();
 
-	glColor3f(1.0f, 1.0f, 1.0f); //sets the color to white
-	glBegin(GL_TRIANGLES); //begin drawing the triangle
-	glVertex2f(PlayerX, PlayerY); //defines 1st vertex
-	glVertex2f(PlayerX + 0.1f, PlayerY); //defines 2nd vertex
-	glVertex2f(PlayerX + 0.05f, PlayerY + 0.1f); //defines 3rd vertex (temp)
-	glEnd(); //ends drawing
+	Batch.begin();
+	Instances.begin();
+
+	draw_entities(snapshot.entities, alpha);
+	draw_particles(snapshot.particles, alpha);
+	draw_effects(snapshot.effects.data(), snapshot.effect_count);
+
+	Instances.flush(); // one upload, one instanced draw call
+	Batch.flush(); // one upload, one draw call per material
+
+	// The HUD and overlays stay put on screen, so they are drawn in clip space after the world
+	matrix_identity(uniforms.view_proj);
+	Render.begin_frame(uniforms);
+	draw_hud(snapshot);
+	if (Paused)
+	{
+		draw_pause_overlay();
+	}
+	if (ShowProfiler)
+	{
+		draw_profiler_overlay();
+	}
+	Batch.flush();
+
+	GpuTime.end();
+	Profiler.record(PHASE_RENDER, render_start, Clock::now());
+
+	if (Offscreen.valid())
+	{
+		OffscreenFramesDone++; // Nothing to present
+	}
+	else
+	{
+		ScopedPhase phase(Profiler, PHASE_SWAP);
+		glutSwapBuffers();
+		Pacer.frame_presented(Clock::now());
+	}
+	if (MeasureLatency)
+	{
+		glFinish(); // Wait until the frame has really been handed to the display
+		Latency.frame_presented(snapshot.tick, Clock::now());
+	}
+	Profiler.end_frame(GpuTime.latest_ms());
+
+	if (!FirstFrameShown)
+	{
+		FirstFrameShown = true;
+		std::printf("Startup to first frame: %.1f ms\n", std::chrono::duration<double, std::milli>(Clock::now() - LaunchTime).count());
+	}
 
-	glutSwapBuffers();
+	BatchStats stats = Batch.stats();
+	stats.draw_calls += Instances.stats().draw_calls;
+	stats.vertices += Instances.stats().vertices;
+	stats.uploads += Instances.stats().uploads;
+	update_frame_counter(stats);
 }
 
 //=================================================================================================
 // INIT
 //=================================================================================================
 
-void init(void)
+// Returns false if the renderer cannot work in the context the window was created with
+bool init(void)
 {
 	// Print some info
 	std::cout << "Vendor:         " << glGetString(GL_VENDOR) << "\n";
@@ -121,10 +823,68 @@ void init(void)
 	// Set the background color
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
+	// Effects fade out through their alpha
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	// Buffer objects are GL 1.5, fall back to client arrays on anything older
+	if (!gl_ext_load())
+	{
+		std::cout << "Vertex buffer objects unavailable, using client-side arrays\n";
+	}
+
+	Render.init(RequestedPath);
+	if (RequestedPath == RENDER_CORE && Render.path() != RENDER_CORE)
+	{
+		std::cout << "The GL 3.3 core path is unusable and a core profile cannot draw fixed function, run with --legacy-gl\n";
+		return false;
+	}
+	std::cout << "Render path:    " << (Render.path() == RENDER_CORE ? "GL 3.3 core" : "fixed function") << "\n";
+	ShaderCache* shaders = Render.path() == RENDER_CORE ? &Render.shaders() : nullptr;
+	Batch.init(65536, shaders);
+	// Prefer the packed bundle; without one, sprites are packed from the loose files and cached
+	Clock::time_point atlas_start = Clock::now();
+	bool from_bundle = Bundle.open(DEFAULT_BUNDLE_PATH) && Atlas.load_bundle(Bundle);
+	if ((from_bundle || Atlas.build("assets/sprites/sprites.txt", "assets/atlas.cache")) && Atlas.upload() != 0)
+	{
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - atlas_start).count();
+		const char* source = from_bundle ? " from bundle" : (Atlas.from_cache() ? " from cache" : " packed");
+		std::cout << "Sprite atlas:   " << Atlas.width() << "x" << Atlas.height() << source << " in " << ms << " ms\n";
+		PlayerSprite = Atlas.find("player");
+	}
+	Font.init();
+	if (Font.upload() != 0)
+	{
+		ScoreText.init(&Font, 32);
+		FpsText.init(&Font, 16);
+	}
+	Instances.init(SHAPE_QUAD, (StressCount > MAX_ENTITIES ? StressCount : MAX_ENTITIES) + MAX_PARTICLES, shaders, &Batch);
+
+	// GPU frame times, when GL_TIME_ELAPSED queries exist
+	GpuTime.init();
+	if (!GpuTime.available())
+	{
+		std::cout << "Timer queries unavailable, the profiler will only show CPU times\n";
+	}
+
 	std::cout << "Finished initializing...\n\n";
 
-	PlayerX = -0.075f; // Edits Players initial starting position (horizontal)
-	PlayerY = -0.9f; // Edits Players initial starting position (Vertical)
+	// Levels are read from the bundle when they were packed, loose files otherwise
+	bool has_level = !LevelPath.empty() && load_level(LevelPath, &Bundle, CurrentLevel);
+	if (has_level)
+	{
+		std::cout << "Level:          " << LevelPath << ", " << CurrentLevel.spawns.size() << " spawns over " << CurrentLevel.length << " ticks\n";
+	}
+	game_init(Game, has_level ? &CurrentLevel : nullptr, &Jobs); // Spawns the player at its starting position
+	if (StressCount > 0)
+	{
+		Stress.init(StressCount, 1234);
+	}
+
+	// Sized once so capturing never allocates, then a first snapshot for the first frame
+	snapshot_buffer_init(Snapshots, StressCount > MAX_ENTITIES ? StressCount : MAX_ENTITIES, MAX_EFFECTS, MAX_PARTICLES);
+	publish_snapshot();
+	return true;
 }
 
 //=================================================================================================
@@ -133,14 +893,204 @@ void init(void)
 
 int main(int argc, char** argv)
 {
+	int fps_cap = 120;
+	bool fps_cap_set = false;
+	VsyncMode vsync = VSYNC_ON;
+	bool vsync_set = false;
+	int refresh_hz = 60; // What vsync is expected to lock to, only used to count missed frames
+	bool headless = false;
+	bool sim_thread = false;
+	HeadlessOptions headless_options;
+	const char* trace_path = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--fps-cap") == 0 && i + 1 < argc)
+		{
+			fps_cap = std::atoi(argv[++i]); // 0 = uncapped
+			fps_cap_set = true;
+		}
+		else if (std::strcmp(argv[i], "--vsync") == 0 && i + 1 < argc)
+		{
+			if (!parse_vsync_mode(argv[++i], vsync))
+			{
+				std::cout << "--vsync takes off, on or adaptive\n";
+				return EXIT_FAILURE;
+			}
+			vsync_set = true;
+		}
+		else if (std::strcmp(argv[i], "--refresh") == 0 && i + 1 < argc)
+		{
+			refresh_hz = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--headless") == 0)
+		{
+			headless = true;
+		}
+		else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+		{
+			headless_options.ticks = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+		{
+			RecordPath = argv[++i];
+			headless_options.record_path = RecordPath;
+		}
+		else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			headless_options.replay_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			headless_options.threads = std::atoi(argv[++i]); // 0 = one per core
+		}
+		else if (std::strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+		{
+			LevelPath = argv[++i];
+			headless_options.level_path = LevelPath;
+		}
+		else if (std::strcmp(argv[i], "--validate-level") == 0 && i + 1 < argc)
+		{
+			return run_validate_level(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			trace_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--stress") == 0 && i + 1 < argc)
+		{
+			StressCount = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--latency") == 0)
+		{
+			MeasureLatency = true;
+		}
+		else if (std::strcmp(argv[i], "--offscreen") == 0 && i + 1 < argc)
+		{
+			OffscreenFrames = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--offscreen-size") == 0 && i + 1 < argc)
+		{
+			if (std::sscanf(argv[++i], "%dx%d", &OffscreenWidth, &OffscreenHeight) != 2)
+			{
+				std::cout << "--offscreen-size takes WIDTHxHEIGHT\n";
+				return EXIT_FAILURE;
+			}
+		}
+		else if (std::strcmp(argv[i], "--offscreen-dump") == 0 && i + 1 < argc)
+		{
+			OffscreenDumpPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--always-redraw") == 0)
+		{
+			AlwaysRedraw = true;
+		}
+		else if (std::strcmp(argv[i], "--sim-thread") == 0)
+		{
+			sim_thread = true;
+		}
+		else if (std::strcmp(argv[i], "--legacy-gl") == 0)
+		{
+			RequestedPath = RENDER_LEGACY;
+		}
+		else if (std::strcmp(argv[i], "--pack-bundle") == 0)
+		{
+			bool has_path = i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0;
+			return run_pack_bundle(has_path ? argv[++i] : DEFAULT_BUNDLE_PATH);
+		}
+		else if (std::strcmp(argv[i], "--bench-entities") == 0)
+		{
+			bench_entities();
+			return EXIT_SUCCESS;
+		}
+		else if (std::strcmp(argv[i], "--bench-collision") == 0)
+		{
+			return bench_collision() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		else if (std::strcmp(argv[i], "--bench-kernel") == 0)
+		{
+			return bench_kernel() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		else if (std::strcmp(argv[i], "--bench-jobs") == 0)
+		{
+			return bench_jobs() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		else if (std::strcmp(argv[i], "--bench-particles") == 0)
+		{
+			return bench_particles() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		else if (std::strcmp(argv[i], "--bench-culling") == 0)
+		{
+			bench_culling();
+			return EXIT_SUCCESS;
+		}
+	}
+
+	// No window, no GL context: just the simulation
+	if (headless)
+	{
+		return run_headless(headless_options);
+	}
+
+	if (!headless_options.replay_path.empty())
+	{
+		if (!ReplayLog.load(headless_options.replay_path))
+		{
+			std::cout << "Could not read input log " << headless_options.replay_path << "\n";
+			return EXIT_FAILURE;
+		}
+		Playback.reset(new InputPlayback(ReplayLog));
+	}
+	Recording.reserve(1 << 16); // A normal session; longer ones grow in reserve_recording between ticks
+
+	// About 20 seconds of frames and ticks at 120 Hz between flushes
+	if (trace_path)
+	{
+		if (!Trace.open(trace_path, 1 << 16))
+		{
+			std::cout << "Could not open trace file " << trace_path << "\n";
+			return EXIT_FAILURE;
+		}
+		Profiler.set_trace(&Trace);
+	}
+
+	// The stress scene measures how fast we can draw, so it runs uncapped unless asked otherwise
+	if (StressCount > 0 && !fps_cap_set)
+	{
+		fps_cap = 0;
+	}
+	if (StressCount > 0 && !vsync_set)
+	{
+		vsync = VSYNC_OFF;
+	}
+
+	Jobs.init(headless_options.threads);
+	std::cout << "Job threads:    " << Jobs.thread_count() << "\n";
+
 	glutInit(&argc, argv);
 
 	glutInitWindowPosition(100, 100);
 	glutInitWindowSize(800, 600);
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
+	glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
+
+	// The core path gets a 3.3 core profile, which macOS and some Mesa drivers only hand out when
+	// asked for explicitly. The fixed-function calls are all errors there, so --legacy-gl asks for a
+	// compatibility profile instead, and init() refuses to fall back inside a core context.
+	if (RequestedPath == RENDER_CORE)
+	{
+		glutInitContextVersion(3, 3);
+		glutInitContextProfile(GLUT_CORE_PROFILE);
+	}
+	else
+	{
+		glutInitContextProfile(GLUT_COMPATIBILITY_PROFILE);
+	}
 
 	glutCreateWindow("Basic OpenGL Example");
 
+	// One press and one release per key; held keys are sampled every tick instead
+	glutIgnoreKeyRepeat(1);
+
 	glutDisplayFunc(display_func);
 	glutIdleFunc(idle_func);
 	glutReshapeFunc(reshape_func);
@@ -152,9 +1102,66 @@ int main(int argc, char** argv)
 	glutMotionFunc(active_motion_func);
 	glutPassiveMotionFunc(passive_motion_func);
 
-	init();
+	if (!init())
+	{
+		return EXIT_FAILURE;
+	}
 
+	if (OffscreenFrames > 0)
+	{
+		if (!Offscreen.init(OffscreenWidth, OffscreenHeight))
+		{
+			std::cout << "Framebuffer objects unavailable, cannot render offscreen\n";
+			return EXIT_FAILURE;
+		}
+		ViewportWidth = OffscreenWidth;
+		ViewportHeight = OffscreenHeight;
+		std::cout << "Offscreen:      " << OffscreenFrames << " frames at " << OffscreenWidth << "x" << OffscreenHeight << "\n";
+		sim_thread = false; // Ticks are tied to frames
+		vsync = VSYNC_OFF; // Nothing is ever swapped
+	}
+
+	// The swap interval belongs to the context, so this has to wait for the window
+	VsyncMode actual_vsync = set_swap_interval(vsync);
+	if (actual_vsync != vsync)
+	{
+		std::cout << "Vsync " << vsync_mode_name(vsync) << " unsupported, using " << vsync_mode_name(actual_vsync) << "\n";
+	}
+	Pacer.init(fps_cap, actual_vsync, refresh_hz);
+	std::cout << "Frame pacing:   vsync " << vsync_mode_name(actual_vsync) << ", cap " << fps_cap << " fps\n";
+
+	if (sim_thread)
+	{
+		SimThread = std::thread(sim_thread_main);
+	}
+
+	Utilization.start(&GpuTime);
 	glutMainLoop();
 
+	if (SimThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(PauseLock);
+			SimStop.store(true, std::memory_order_relaxed);
+		}
+		PauseChanged.notify_all();
+		SimThread.join();
+	}
+
+	finish_session();
+	Profiler.print_summary();
+	Latency.print_summary();
+	Utilization.print_summary();
+	Pacer.print_summary();
+
+	if (Trace.enabled())
+	{
+		Trace.close();
+		if (Trace.dropped() > 0)
+		{
+			std::cout << "Trace buffer overflowed, " << Trace.dropped() << " spans dropped (flush with F9 more often)\n";
+		}
+	}
+
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
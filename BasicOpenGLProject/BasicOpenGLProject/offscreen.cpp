@@ -0,0 +1,95 @@
+#include "offscreen.h"
+#include "gl_ext.h"
+
+#include <cstring>
+
+bool OffscreenTarget::init(int width, int height)
+{
+	shutdown();
+	if (!gl_ext_has_fbo() || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+
+	pglGenRenderbuffers(1, &color);
+	pglBindRenderbuffer(GL_RENDERBUFFER, color);
+	pglRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	// The window was asked for a depth buffer too, so frames clear and draw the same way here
+	pglGenRenderbuffers(1, &depth);
+	pglBindRenderbuffer(GL_RENDERBUFFER, depth);
+	pglRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	pglBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	pglGenFramebuffers(1, &fbo);
+	pglBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	pglFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	pglFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+	bool complete = pglCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	pglBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (!complete)
+	{
+		shutdown();
+		return false;
+	}
+
+	target_width = width;
+	target_height = height;
+	return true;
+}
+
+void OffscreenTarget::shutdown()
+{
+	if (fbo != 0)
+	{
+		pglDeleteFramebuffers(1, &fbo);
+		fbo = 0;
+	}
+	if (color != 0)
+	{
+		pglDeleteRenderbuffers(1, &color);
+		color = 0;
+	}
+	if (depth != 0)
+	{
+		pglDeleteRenderbuffers(1, &depth);
+		depth = 0;
+	}
+	target_width = 0;
+	target_height = 0;
+}
+
+void OffscreenTarget::bind()
+{
+	pglBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, target_width, target_height);
+}
+
+void OffscreenTarget::unbind()
+{
+	pglBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void OffscreenTarget::read_pixels(Image& image)
+{
+	image.width = target_width;
+	image.height = target_height;
+	image.rgba.resize(static_cast<size_t>(target_width) * target_height * 4);
+
+	pglBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, target_width, target_height, GL_RGBA, GL_UNSIGNED_BYTE, image.rgba.data());
+
+	// GL rows start at the bottom
+	const size_t row_size = static_cast<size_t>(target_width) * 4;
+	std::vector<unsigned char> row(row_size);
+	for (int y = 0; y < target_height / 2; ++y)
+	{
+		unsigned char* top = &image.rgba[y * row_size];
+		unsigned char* bottom = &image.rgba[(target_height - 1 - y) * row_size];
+		std::memcpy(row.data(), top, row_size);
+		std::memcpy(top, bottom, row_size);
+		std::memcpy(bottom, row.data(), row_size);
+	}
+}
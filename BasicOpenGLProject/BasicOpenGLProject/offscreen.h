@@ -0,0 +1,42 @@
+#pragma once
+
+#include "image.h"
+
+#include <GL/freeglut.h>
+
+//=================================================================================================
+// OFFSCREEN TARGET
+//
+// A framebuffer object with a colour and a depth renderbuffer at a fixed size, so frames can be
+// rendered and timed at a resolution that has nothing to do with the window, without ever being
+// presented. read_pixels copies the result back for screenshots and golden-image tests.
+//=================================================================================================
+
+class OffscreenTarget
+{
+public:
+	// Needs a current context and gl_ext_load. False if framebuffer objects are unavailable or the
+	// driver rejects the format.
+	bool init(int width, int height);
+	void shutdown();
+
+	bool valid() const { return fbo != 0; }
+	int width() const { return target_width; }
+	int height() const { return target_height; }
+
+	// Draws go to the target from here on, with the viewport covering all of it
+	void bind();
+
+	// Back to the window's framebuffer; the caller restores its own viewport
+	void unbind();
+
+	// Copies the colour buffer into image, top row first. Leaves the target bound.
+	void read_pixels(Image& image);
+
+private:
+	GLuint fbo = 0;
+	GLuint color = 0;
+	GLuint depth = 0;
+	int target_width = 0;
+	int target_height = 0;
+};
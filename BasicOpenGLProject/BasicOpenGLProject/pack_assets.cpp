@@ -0,0 +1,64 @@
+#include "pack_assets.h"
+#include "atlas.h"
+#include "bundle.h"
+#include "image.h"
+#include "level.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+int run_pack_bundle(const std::string& out_path)
+{
+	std::vector<BundleInput> inputs;
+
+	// No cache: the packer always starts from the source images
+	TextureAtlas atlas;
+	if (!atlas.build("assets/sprites/sprites.txt", ""))
+	{
+		return EXIT_FAILURE;
+	}
+	atlas.to_bundle(inputs);
+
+	// Levels go in as text, under the same path the game would load them from. Broken levels are
+	// refused here rather than at startup.
+	std::vector<std::string> levels;
+	if (!read_manifest("assets/levels/levels.txt", levels))
+	{
+		std::printf("Could not read level manifest assets/levels/levels.txt\n");
+		return EXIT_FAILURE;
+	}
+	for (const std::string& path : levels)
+	{
+		BundleInput input;
+		input.name = path;
+		input.type = BUNDLE_RAW;
+		Level level;
+		if (!read_file(path, input.bytes) || !load_level(path, nullptr, level))
+		{
+			std::printf("Could not pack level %s\n", path.c_str());
+			return EXIT_FAILURE;
+		}
+		inputs.push_back(input);
+	}
+
+	if (!write_bundle(out_path, inputs))
+	{
+		std::printf("Could not write bundle %s\n", out_path.c_str());
+		return EXIT_FAILURE;
+	}
+
+	AssetBundle check;
+	if (!check.open(out_path))
+	{
+		std::printf("Bundle %s was written but does not read back\n", out_path.c_str());
+		return EXIT_FAILURE;
+	}
+
+	std::printf("Packed %u assets into %s (%zu bytes)\n", check.entry_count(), out_path.c_str(), check.size());
+	for (const BundleInput& input : inputs)
+	{
+		std::printf("  %-24s type %d, %zu bytes\n", input.name.c_str(), static_cast<int>(input.type), input.bytes.size());
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+//=================================================================================================
+// ASSET PACKER
+//
+// Offline tool behind --pack-bundle: gathers the loose files under assets/ (sprites packed into
+// the atlas, levels as raw text) and writes them as one asset bundle.
+//=================================================================================================
+
+const char* const DEFAULT_BUNDLE_PATH = "assets/game.bundle";
+
+// Returns the process exit code
+int run_pack_bundle(const std::string& out_path);
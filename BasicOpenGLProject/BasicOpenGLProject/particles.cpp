@@ -0,0 +1,310 @@
+#include "particles.h"
+#include "collision_kernel.h"
+#include "game_loop.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PARTICLES_X86 1
+#include <emmintrin.h>
+#endif
+
+#if defined(PARTICLES_X86) && defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define TARGET_SSE2
+#endif
+
+const int ParticleSystem::UNITS;
+const int ParticleSystem::DRAG_SHIFT;
+const int ParticleSystem::FADE_TICKS;
+
+static const size_t LANES = 8; // Arrays are padded to whole SSE2 registers
+
+// Directions are picked from a table so emitting costs no trig
+static const int DIRECTIONS = 256;
+static float DirectionX[DIRECTIONS];
+static float DirectionY[DIRECTIONS];
+
+static void init_directions()
+{
+	for (int i = 0; i < DIRECTIONS; ++i)
+	{
+		float angle = i * (6.2831853f / DIRECTIONS);
+		DirectionX[i] = std::cos(angle);
+		DirectionY[i] = std::sin(angle);
+	}
+}
+
+static std::int16_t to_fixed(float value)
+{
+	float scaled = value * ParticleSystem::UNITS;
+	scaled = scaled > 32767.0f ? 32767.0f : (scaled < -32768.0f ? -32768.0f : scaled);
+	return static_cast<std::int16_t>(std::lround(scaled));
+}
+
+//=================================================================================================
+// KERNELS
+//=================================================================================================
+
+// Integer versions of exactly what the SSE2 instructions do
+static std::int16_t adds(std::int16_t a, std::int16_t b)
+{
+	int sum = a + b;
+	return static_cast<std::int16_t>(sum > 32767 ? 32767 : (sum < -32768 ? -32768 : sum));
+}
+
+// Velocity lost to drag: v / 32 rounded away from zero, so every velocity decays all the way to 0
+// instead of small positive ones drifting forever while negative ones stop
+static std::int16_t drag(std::int16_t v)
+{
+	const int bias = v >= 0 ? (1 << ParticleSystem::DRAG_SHIFT) - 1 : 0;
+	return static_cast<std::int16_t>(adds(v, static_cast<std::int16_t>(bias)) >> ParticleSystem::DRAG_SHIFT);
+}
+
+static void step_scalar(std::int16_t* px, std::int16_t* py, std::int16_t* vx, std::int16_t* vy, std::uint16_t* life, size_t n)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		px[i] = adds(px[i], vx[i]);
+		py[i] = adds(py[i], vy[i]);
+		vx[i] = static_cast<std::int16_t>(vx[i] - drag(vx[i]));
+		vy[i] = static_cast<std::int16_t>(vy[i] - drag(vy[i]));
+		life[i] = life[i] > 0 ? life[i] - 1 : 0;
+	}
+}
+
+#ifdef PARTICLES_X86
+
+TARGET_SSE2 static __m128i drag_sse2(__m128i v)
+{
+	const __m128i bias = _mm_set1_epi16((1 << ParticleSystem::DRAG_SHIFT) - 1);
+	__m128i negative = _mm_srai_epi16(v, 15);
+	return _mm_srai_epi16(_mm_adds_epi16(v, _mm_andnot_si128(negative, bias)), ParticleSystem::DRAG_SHIFT);
+}
+
+TARGET_SSE2 static void step_sse2(std::int16_t* px, std::int16_t* py, std::int16_t* vx, std::int16_t* vy, std::uint16_t* life, size_t n)
+{
+	const __m128i one = _mm_set1_epi16(1);
+	for (size_t i = 0; i < n; i += LANES)
+	{
+		__m128i* x = reinterpret_cast<__m128i*>(px + i);
+		__m128i* y = reinterpret_cast<__m128i*>(py + i);
+		__m128i* u = reinterpret_cast<__m128i*>(vx + i);
+		__m128i* v = reinterpret_cast<__m128i*>(vy + i);
+		__m128i* l = reinterpret_cast<__m128i*>(life + i);
+
+		__m128i velocity_x = _mm_loadu_si128(u);
+		__m128i velocity_y = _mm_loadu_si128(v);
+		_mm_storeu_si128(x, _mm_adds_epi16(_mm_loadu_si128(x), velocity_x));
+		_mm_storeu_si128(y, _mm_adds_epi16(_mm_loadu_si128(y), velocity_y));
+		_mm_storeu_si128(u, _mm_sub_epi16(velocity_x, drag_sse2(velocity_x)));
+		_mm_storeu_si128(v, _mm_sub_epi16(velocity_y, drag_sse2(velocity_y)));
+		_mm_storeu_si128(l, _mm_subs_epu16(_mm_loadu_si128(l), one));
+	}
+}
+
+#else
+
+static void step_sse2(std::int16_t* px, std::int16_t* py, std::int16_t* vx, std::int16_t* vy, std::uint16_t* life, size_t n)
+{
+	step_scalar(px, py, vx, vy, life, n);
+}
+
+#endif
+
+const char* particle_kernel_name()
+{
+	return cpu_has_sse2() ? "sse2" : "scalar";
+}
+
+//=================================================================================================
+// PARTICLE SYSTEM
+//=================================================================================================
+
+void ParticleSystem::resize_arrays(size_t n)
+{
+	n = (n + LANES - 1) / LANES * LANES;
+	pos_x.resize(n);
+	pos_y.resize(n);
+	vel_x.resize(n);
+	vel_y.resize(n);
+	life.resize(n);
+	kind.resize(n);
+}
+
+void ParticleSystem::init(size_t capacity)
+{
+	init_directions();
+	resize_arrays(capacity);
+	max_count = capacity;
+	count = 0;
+	origin_fx = origin_fy = 0;
+}
+
+size_t ParticleSystem::emit(ParticleKind particle_kind, float x, float y, size_t n, float vx, float vy, float spread, int lifetime)
+{
+	n = std::min(n, max_count - count);
+
+	// Per-second speeds become per-tick steps
+	const float per_tick = TICK_DT;
+	const std::int16_t fx = to_fixed(x - origin_x());
+	const std::int16_t fy = to_fixed(y - origin_y());
+	const std::uint16_t ticks = static_cast<std::uint16_t>(std::min(std::max(lifetime, 1), 65535));
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		// xorshift32: direction from the low byte, speed from the next one
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+		int direction = rng & (DIRECTIONS - 1);
+		float speed = spread * ((rng >> 8) & 255) * (1.0f / 255.0f);
+
+		size_t p = count++;
+		pos_x[p] = fx;
+		pos_y[p] = fy;
+		vel_x[p] = to_fixed((vx + DirectionX[direction] * speed) * per_tick);
+		vel_y[p] = to_fixed((vy + DirectionY[direction] * speed) * per_tick);
+		life[p] = static_cast<std::uint16_t>(ticks - ((rng >> 16) % (ticks / 4 + 1))); // Don't all vanish on the same tick
+		kind[p] = particle_kind;
+	}
+	return n;
+}
+
+void ParticleSystem::recenter(float x, float y)
+{
+	const std::int32_t fx = static_cast<std::int32_t>(std::lround(x * UNITS));
+	const std::int32_t fy = static_cast<std::int32_t>(std::lround(y * UNITS));
+	const int dx = fx - origin_fx;
+	const int dy = fy - origin_fy;
+	if (dx == 0 && dy == 0)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		int px = pos_x[i] - dx;
+		int py = pos_y[i] - dy;
+		pos_x[i] = static_cast<std::int16_t>(px > 32767 ? 32767 : (px < -32768 ? -32768 : px));
+		pos_y[i] = static_cast<std::int16_t>(py > 32767 ? 32767 : (py < -32768 ? -32768 : py));
+	}
+	origin_fx = fx;
+	origin_fy = fy;
+}
+
+void ParticleSystem::update(ParticleKernel kernel)
+{
+	// The arrays are padded, so the kernels can always run whole registers
+	const size_t n = (count + LANES - 1) / LANES * LANES;
+	bool sse2 = kernel == PARTICLE_KERNEL_SSE2 || (kernel == PARTICLE_KERNEL_BEST && cpu_has_sse2());
+	if (sse2)
+	{
+		step_sse2(pos_x.data(), pos_y.data(), vel_x.data(), vel_y.data(), life.data(), n);
+	}
+	else
+	{
+		step_scalar(pos_x.data(), pos_y.data(), vel_x.data(), vel_y.data(), life.data(), n);
+	}
+
+	// Swap the last live particle into each dead one
+	const int limit = UNITS + UNITS / 4;
+	size_t i = 0;
+	while (i < count)
+	{
+		if (life[i] != 0 && pos_x[i] > -limit && pos_x[i] < limit && pos_y[i] > -limit && pos_y[i] < limit)
+		{
+			++i;
+			continue;
+		}
+
+		size_t last = --count;
+		pos_x[i] = pos_x[last];
+		pos_y[i] = pos_y[last];
+		vel_x[i] = vel_x[last];
+		vel_y[i] = vel_y[last];
+		life[i] = life[last];
+		kind[i] = kind[last];
+	}
+}
+
+void ParticleSystem::copy_for_render(const ParticleSystem& source)
+{
+	if (source.count > pos_x.size())
+	{
+		resize_arrays(source.max_count);
+	}
+	max_count = std::max(max_count, source.count);
+
+	const size_t n = source.count;
+	std::copy(source.pos_x.begin(), source.pos_x.begin() + n, pos_x.begin());
+	std::copy(source.pos_y.begin(), source.pos_y.begin() + n, pos_y.begin());
+	std::copy(source.vel_x.begin(), source.vel_x.begin() + n, vel_x.begin());
+	std::copy(source.vel_y.begin(), source.vel_y.begin() + n, vel_y.begin());
+	std::copy(source.life.begin(), source.life.begin() + n, life.begin());
+	std::copy(source.kind.begin(), source.kind.begin() + n, kind.begin());
+	count = n;
+	origin_fx = source.origin_fx;
+	origin_fy = source.origin_fy;
+}
+
+// A world coordinate as a fixed-point offset from origin, clamped to the range particles can hold
+static std::int32_t to_fixed(float value, std::int32_t origin)
+{
+	float steps = value * ParticleSystem::UNITS - static_cast<float>(origin);
+	return static_cast<std::int32_t>(std::max(-32768.0f, std::min(32767.0f, steps)));
+}
+
+void ParticleSystem::copy_for_render(const ParticleSystem& source, const Aabb& view)
+{
+	if (source.count > pos_x.size())
+	{
+		resize_arrays(source.max_count);
+	}
+	max_count = std::max(max_count, source.count);
+
+	const std::int32_t min_x = to_fixed(view.min_x, source.origin_fx);
+	const std::int32_t max_x = to_fixed(view.max_x, source.origin_fx);
+	const std::int32_t min_y = to_fixed(view.min_y, source.origin_fy);
+	const std::int32_t max_y = to_fixed(view.max_y, source.origin_fy);
+
+	// Like EntityStore::copy_for_render: the visibility test runs a block at a time in a loop of
+	// its own, then only the visible particles are copied
+	const std::int16_t* __restrict sx = source.pos_x.data();
+	const std::int16_t* __restrict sy = source.pos_y.data();
+
+	const size_t BLOCK = 256;
+	std::uint8_t visible[BLOCK];
+	size_t n = 0;
+	for (size_t first = 0; first < source.count; first += BLOCK)
+	{
+		const size_t block = std::min(BLOCK, source.count - first);
+		for (size_t i = 0; i < block; ++i)
+		{
+			const size_t s = first + i;
+			visible[i] = (sx[s] >= min_x) & (sx[s] <= max_x) & (sy[s] >= min_y) & (sy[s] <= max_y);
+		}
+
+		for (size_t i = 0; i < block; ++i)
+		{
+			if (!visible[i])
+			{
+				continue;
+			}
+
+			const size_t s = first + i;
+			pos_x[n] = sx[s];
+			pos_y[n] = sy[s];
+			vel_x[n] = source.vel_x[s];
+			vel_y[n] = source.vel_y[s];
+			life[n] = source.life[s];
+			kind[n] = source.kind[s];
+			n++;
+		}
+	}
+	count = n;
+	origin_fx = source.origin_fx;
+	origin_fy = source.origin_fy;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "collision_kernel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//=================================================================================================
+// PARTICLES
+//
+// Explosion sparks and engine trails, up to a hundred thousand or so at once. Each particle is
+// eleven bytes spread over separate arrays: position and velocity as 16-bit fixed point
+// (UNITS per field unit, velocity per tick), remaining life as 16-bit ticks and a kind byte. Eight
+// particles fit in one SSE2 register per field, and saturating adds keep positions from wrapping
+// around when they fly off the field. Everything is integer math, so the SIMD and scalar paths
+// agree exactly and the result is the same on every machine. Positions are relative to an origin
+// that follows the camera, so a scrolling world does not run out of fixed-point range.
+//
+// Particles never affect the game, they are only ever drawn.
+//=================================================================================================
+
+enum ParticleKind : std::uint8_t
+{
+	PARTICLE_SPARK, // Explosions
+	PARTICLE_EXHAUST, // Trail below the player
+};
+
+enum ParticleKernel
+{
+	PARTICLE_KERNEL_BEST, // SSE2 when the CPU has it
+	PARTICLE_KERNEL_SCALAR,
+	PARTICLE_KERNEL_SSE2,
+};
+
+class ParticleSystem
+{
+public:
+	static const int UNITS = 8192; // Fixed-point steps per field unit, so positions reach +-4
+	static const int DRAG_SHIFT = 5; // Velocity loses 1/32 of itself every tick
+	static const int FADE_TICKS = 16; // Particles fade out over their last ticks
+
+	// Allocates room for capacity particles, emitting never allocates after this
+	void init(size_t capacity);
+	void clear() { count = 0; }
+
+	// Spawns up to count particles at (x, y) moving at (vx, vy) units per second plus a random
+	// velocity of up to spread in any direction. Returns how many fit.
+	size_t emit(ParticleKind kind, float x, float y, size_t count, float vx, float vy, float spread, int lifetime);
+
+	// Moves the origin to the fixed-point step nearest (x, y) and shifts every particle so it stays
+	// where it is in the world. Particles too far from the new origin are dropped by the next update.
+	void recenter(float x, float y);
+
+	float origin_x() const { return static_cast<float>(origin_fx) / UNITS; }
+	float origin_y() const { return static_cast<float>(origin_fy) / UNITS; }
+
+	// One tick: integrates position, velocity and life, then drops particles that died or left the
+	// field around the origin. All kernels give identical results.
+	void update(ParticleKernel kernel = PARTICLE_KERNEL_BEST);
+
+	// Copies the live particles of source, for drawing on another thread. Allocates only when
+	// source holds more than this system ever did.
+	void copy_for_render(const ParticleSystem& source);
+
+	// Same, but only the particles inside view (world units)
+	void copy_for_render(const ParticleSystem& source, const Aabb& view);
+
+	size_t size() const { return count; }
+	size_t capacity() const { return max_count; }
+
+	std::vector<std::int16_t> pos_x, pos_y;
+	std::vector<std::int16_t> vel_x, vel_y;
+	std::vector<std::uint16_t> life; // Ticks left
+	std::vector<std::uint8_t> kind;
+
+private:
+	void resize_arrays(size_t n);
+
+	size_t count = 0;
+	size_t max_count = 0;
+	std::int32_t origin_fx = 0, origin_fy = 0; // In fixed-point steps
+	std::uint32_t rng = 0x9E3779B9u;
+};
+
+// Name of the kernel PARTICLE_KERNEL_BEST runs
+const char* particle_kernel_name();
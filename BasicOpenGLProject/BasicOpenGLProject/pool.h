@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//=================================================================================================
+// OBJECT POOL
+//
+// Fixed-capacity storage for short-lived objects (effects, pickups, ...). All memory is allocated
+// once in init(); acquire/release just pop and push slot indices on a free list, so spawning and
+// despawning in the middle of a frame never touches the heap.
+//=================================================================================================
+
+template <typename T>
+class ObjectPool
+{
+public:
+	void init(size_t capacity)
+	{
+		slots.assign(capacity, T());
+		live.assign(capacity, 0);
+		free_list.clear();
+		free_list.reserve(capacity);
+		for (size_t i = capacity; i > 0; --i)
+		{
+			free_list.push_back(static_cast<std::uint32_t>(i - 1));
+		}
+		live_count = 0;
+	}
+
+	// Returns nullptr when the pool is exhausted, callers simply skip the spawn
+	T* acquire()
+	{
+		if (free_list.empty())
+		{
+			return nullptr;
+		}
+
+		std::uint32_t index = free_list.back();
+		free_list.pop_back();
+		live[index] = 1;
+		live_count++;
+		slots[index] = T();
+		return &slots[index];
+	}
+
+	void release(T* object)
+	{
+		size_t index = static_cast<size_t>(object - slots.data());
+		if (index >= slots.size() || !live[index])
+		{
+			return;
+		}
+
+		live[index] = 0;
+		live_count--;
+		free_list.push_back(static_cast<std::uint32_t>(index));
+	}
+
+	// Calls fn(T&) for every live object. fn may release the object it is given.
+	template <typename Fn>
+	void for_each(Fn fn)
+	{
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			if (live[i])
+			{
+				fn(slots[i]);
+			}
+		}
+	}
+
+	template <typename Fn>
+	void for_each(Fn fn) const
+	{
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			if (live[i])
+			{
+				fn(slots[i]);
+			}
+		}
+	}
+
+	size_t size() const { return live_count; }
+	size_t capacity() const { return slots.size(); }
+
+private:
+	std::vector<T> slots;
+	std::vector<std::uint8_t> live;
+	std::vector<std::uint32_t> free_list;
+	size_t live_count = 0;
+};
@@ -0,0 +1,340 @@
+#include "profiler.h"
+#include "gl_ext.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+const size_t FrameProfiler::HISTORY;
+
+const char* profile_phase_name(ProfilePhase phase)
+{
+	switch (phase)
+	{
+	case PHASE_INPUT: return "input";
+	case PHASE_UPDATE: return "update";
+	case PHASE_RENDER: return "display_func";
+	case PHASE_SWAP: return "glutSwapBuffers";
+	default: return "?";
+	}
+}
+
+void FrameProfiler::record(ProfilePhase phase, Clock::time_point start, Clock::time_point end)
+{
+	current.phase_ms[phase] += std::chrono::duration<float, std::milli>(end - start).count();
+
+	if (trace && trace->enabled())
+	{
+		trace->span(profile_phase_name(phase), start, end);
+	}
+}
+
+void FrameProfiler::end_frame(float gpu_ms)
+{
+	Clock::time_point now = Clock::now();
+	if (trace && trace->enabled())
+	{
+		trace->span("frame", last_frame_end, now);
+	}
+
+	current.frame_ms = std::chrono::duration<float, std::milli>(now - last_frame_end).count();
+	current.gpu_ms = gpu_ms;
+	last_frame_end = now;
+
+	std::uint64_t n = written.load(std::memory_order_relaxed);
+	ring[n % HISTORY] = current;
+	written.store(n + 1, std::memory_order_release);
+
+	current = FrameSample();
+}
+
+size_t FrameProfiler::recent(FrameSample* out, size_t max) const
+{
+	std::uint64_t n = written.load(std::memory_order_acquire);
+	size_t count = static_cast<size_t>(std::min<std::uint64_t>(n, std::min(max, HISTORY)));
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		out[i] = ring[(n - count + i) % HISTORY];
+	}
+	return count;
+}
+
+// Nearest-rank percentile, values gets reordered
+static float percentile(std::vector<float>& values, double p)
+{
+	size_t rank = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+	std::nth_element(values.begin(), values.begin() + rank, values.end());
+	return values[rank];
+}
+
+void FrameProfiler::print_summary() const
+{
+	std::vector<FrameSample> samples(HISTORY);
+	samples.resize(recent(samples.data(), HISTORY));
+	if (samples.empty())
+	{
+		return;
+	}
+
+	std::printf("Frame times over the last %zu frames (ms)\n", samples.size());
+	std::printf("  %-16s %8s %8s %8s %8s\n", "phase", "p50", "p95", "p99", "max");
+
+	std::vector<float> values;
+	auto row = [&](const char* name)
+	{
+		if (values.empty())
+		{
+			return;
+		}
+		float max = *std::max_element(values.begin(), values.end());
+		float p50 = percentile(values, 0.50);
+		float p95 = percentile(values, 0.95);
+		float p99 = percentile(values, 0.99);
+		std::printf("  %-16s %8.3f %8.3f %8.3f %8.3f\n", name, p50, p95, p99, max);
+	};
+
+	for (int phase = 0; phase < PHASE_COUNT; ++phase)
+	{
+		values.clear();
+		for (const FrameSample& sample : samples)
+		{
+			values.push_back(sample.phase_ms[phase]);
+		}
+		row(profile_phase_name(static_cast<ProfilePhase>(phase)));
+	}
+
+	values.clear();
+	for (const FrameSample& sample : samples)
+	{
+		values.push_back(sample.frame_ms);
+	}
+	row("frame");
+
+	values.clear();
+	for (const FrameSample& sample : samples)
+	{
+		if (sample.gpu_ms >= 0.0f)
+		{
+			values.push_back(sample.gpu_ms);
+		}
+	}
+	row("gpu");
+}
+
+//=================================================================================================
+// LATENCY METER
+//=================================================================================================
+
+const size_t LatencyMeter::MAX_SAMPLES;
+
+void LatencyMeter::key_pressed(std::uint32_t tick, Clock::time_point time)
+{
+	if (pending)
+	{
+		return;
+	}
+	pending = true;
+	pending_tick = tick;
+	pending_time = time;
+}
+
+void LatencyMeter::frame_presented(std::uint32_t ticks, Clock::time_point time)
+{
+	// The press is applied right before pending_tick is simulated
+	if (!pending || ticks <= pending_tick)
+	{
+		return;
+	}
+	pending = false;
+
+	float ms = std::chrono::duration<float, std::milli>(time - pending_time).count();
+	samples[count % MAX_SAMPLES] = ms;
+	count++;
+	std::printf("Input to photon: %.2f ms\n", ms);
+}
+
+void LatencyMeter::print_summary() const
+{
+	std::vector<float> values(sample_count());
+	std::copy(samples, samples + values.size(), values.begin());
+	if (values.empty())
+	{
+		return;
+	}
+
+	float min = *std::min_element(values.begin(), values.end());
+	float max = *std::max_element(values.begin(), values.end());
+	float p50 = percentile(values, 0.50);
+	float p95 = percentile(values, 0.95);
+	std::printf("Input to photon over %zu presses (ms): min %.2f, p50 %.2f, p95 %.2f, max %.2f\n",
+		values.size(), min, p50, p95, max);
+}
+
+//=================================================================================================
+// GPU TIMER
+//=================================================================================================
+
+void GpuTimer::init()
+{
+	if (gl_ext_has_timer_query())
+	{
+		pglGenQueries(LATENCY, queries);
+	}
+}
+
+void GpuTimer::shutdown()
+{
+	if (available())
+	{
+		pglDeleteQueries(LATENCY, queries);
+		std::fill(queries, queries + LATENCY, 0u);
+	}
+}
+
+void GpuTimer::begin()
+{
+	if (!available())
+	{
+		return;
+	}
+
+	// Collect the oldest query before reusing it, skipping it if the GPU is still that far behind
+	int slot = frame % LATENCY;
+	if (pending[slot])
+	{
+		GLint ready = 0;
+		pglGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &ready);
+		if (!ready)
+		{
+			return;
+		}
+
+		std::uint64_t ns = 0;
+		pglGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &ns);
+		latest = static_cast<float>(ns / 1e6);
+		total += ns / 1e6;
+		pending[slot] = false;
+	}
+
+	pglBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+	pending[slot] = true;
+	active = true;
+}
+
+void GpuTimer::end()
+{
+	if (!available())
+	{
+		return;
+	}
+
+	// begin() may have skipped this frame
+	if (active)
+	{
+		pglEndQuery(GL_TIME_ELAPSED);
+		active = false;
+	}
+	frame++;
+}
+
+//=================================================================================================
+// UTILIZATION
+//=================================================================================================
+
+double process_cpu_seconds()
+{
+#ifdef _WIN32
+	FILETIME created, exited, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+	{
+		return 0.0;
+	}
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return (k.QuadPart + u.QuadPart) * 1e-7; // 100 ns units
+#else
+	timespec now;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != 0)
+	{
+		return 0.0;
+	}
+	return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+void UtilizationMeter::start(const GpuTimer* gpu)
+{
+	gpu_timer = gpu && gpu->available() ? gpu : nullptr;
+	started = true;
+	still = false;
+	usage[0] = usage[1] = Usage();
+	period_start = Clock::now();
+	period_cpu = process_cpu_seconds();
+	period_gpu = gpu_timer ? gpu_timer->total_ms() : 0.0;
+}
+
+void UtilizationMeter::set_still(bool is_still)
+{
+	if (!started || is_still == still)
+	{
+		return;
+	}
+
+	totals(usage);
+	still = is_still;
+	period_start = Clock::now();
+	period_cpu = process_cpu_seconds();
+	period_gpu = gpu_timer ? gpu_timer->total_ms() : 0.0;
+}
+
+void UtilizationMeter::totals(Usage out[2]) const
+{
+	out[0] = usage[0];
+	out[1] = usage[1];
+
+	Usage& open = out[still ? 1 : 0];
+	open.wall_s += std::chrono::duration<double>(Clock::now() - period_start).count();
+	open.cpu_s += process_cpu_seconds() - period_cpu;
+	if (gpu_timer)
+	{
+		open.gpu_ms += gpu_timer->total_ms() - period_gpu;
+	}
+}
+
+void UtilizationMeter::print_summary() const
+{
+	if (!started)
+	{
+		return;
+	}
+
+	Usage all[2];
+	totals(all);
+	const char* names[2] = { "redrawing", "still" };
+	for (int i = 0; i < 2; ++i)
+	{
+		if (all[i].wall_s <= 0.0)
+		{
+			continue;
+		}
+
+		std::printf("Utilization while %s for %.1f s: CPU %.1f%% of a core", names[i], all[i].wall_s, 100.0 * all[i].cpu_s / all[i].wall_s);
+		if (gpu_timer)
+		{
+			std::printf(", GPU %.1f%%", 0.1 * all[i].gpu_ms / all[i].wall_s);
+		}
+		std::printf("\n");
+	}
+}
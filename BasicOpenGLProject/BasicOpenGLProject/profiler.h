@@ -0,0 +1,173 @@
+#pragma once
+
+#include "game_loop.h"
+#include "trace.h"
+
+#include <GL/freeglut.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+//=================================================================================================
+// PROFILER
+//
+// Per-frame CPU timings for each phase of the loop, kept in a ring buffer of the last HISTORY
+// frames. The GLUT thread is the only writer; readers (the overlay, the exit summary) copy
+// samples out without taking a lock. With a TraceWriter attached every phase and frame is also
+// emitted as a trace span.
+//=================================================================================================
+
+enum ProfilePhase
+{
+	PHASE_INPUT, // Keyboard callbacks
+	PHASE_UPDATE, // Simulation ticks run from idle_func
+	PHASE_RENDER, // display_func up to the swap
+	PHASE_SWAP, // glutSwapBuffers
+	PHASE_COUNT
+};
+
+const char* profile_phase_name(ProfilePhase phase);
+
+struct FrameSample
+{
+	float phase_ms[PHASE_COUNT];
+	float frame_ms; // Wall time since the previous frame ended
+	float gpu_ms; // GPU time of a recent frame, negative when unavailable
+};
+
+class FrameProfiler
+{
+public:
+	static const size_t HISTORY = 4096;
+
+	void set_trace(TraceWriter* writer) { trace = writer; }
+
+	// Adds a span of time to a phase of the frame currently being built
+	void record(ProfilePhase phase, Clock::time_point start, Clock::time_point end);
+
+	// Publishes the current frame to the ring and starts the next one
+	void end_frame(float gpu_ms);
+
+	// Copies up to max of the most recent samples into out, oldest first. Returns the count.
+	size_t recent(FrameSample* out, size_t max) const;
+
+	std::uint64_t frame_count() const { return written.load(std::memory_order_acquire); }
+
+	// p50/p95/p99 of every phase over the frames still in the ring
+	void print_summary() const;
+
+private:
+	FrameSample ring[HISTORY] = {};
+	std::atomic<std::uint64_t> written{ 0 };
+	FrameSample current = {};
+	Clock::time_point last_frame_end = Clock::now();
+	TraceWriter* trace = nullptr;
+};
+
+// Times its own lifetime into a profiler phase
+class ScopedPhase
+{
+public:
+	ScopedPhase(FrameProfiler& profiler, ProfilePhase phase) : profiler(profiler), phase(phase), start(Clock::now()) {}
+
+	~ScopedPhase()
+	{
+		profiler.record(phase, start, Clock::now());
+	}
+
+private:
+	FrameProfiler& profiler;
+	ProfilePhase phase;
+	Clock::time_point start;
+};
+
+// --latency: time from a key press reaching the callback to the end of the swap of the first frame
+// drawn from a tick that applied it. glFinish after the swap stands in for the photons, so this is
+// what the game adds on top of the display's own scanout delay. GLUT thread only.
+class LatencyMeter
+{
+public:
+	static const size_t MAX_SAMPLES = 1024;
+
+	// A press stamped for tick arrived at time. Ignored while an earlier press is still in flight.
+	void key_pressed(std::uint32_t tick, Clock::time_point time);
+
+	// A frame drawn from a snapshot taken after ticks ticks finished presenting at time
+	void frame_presented(std::uint32_t ticks, Clock::time_point time);
+
+	size_t sample_count() const { return count < MAX_SAMPLES ? count : MAX_SAMPLES; }
+
+	// min/p50/p95/max over the samples kept
+	void print_summary() const;
+
+private:
+	float samples[MAX_SAMPLES] = {}; // Ring, the oldest are overwritten
+	size_t count = 0;
+	bool pending = false;
+	std::uint32_t pending_tick = 0;
+	Clock::time_point pending_time;
+};
+
+// GL_TIME_ELAPSED queries around the frame's GL work. Results are read a few frames later so the
+// CPU never waits for the GPU; latest_ms() is the newest result that has arrived.
+class GpuTimer
+{
+public:
+	// Needs a current context and gl_ext_load. Does nothing if timer queries are unsupported.
+	void init();
+	void shutdown();
+
+	void begin();
+	void end();
+
+	bool available() const { return queries[0] != 0; }
+	float latest_ms() const { return latest; }
+	double total_ms() const { return total; } // Every result read so far
+
+private:
+	static const int LATENCY = 4; // Queries in flight
+
+	GLuint queries[LATENCY] = {};
+	bool pending[LATENCY] = {};
+	int frame = 0;
+	bool active = false; // A query was begun this frame
+	float latest = -1.0f;
+	double total = 0.0;
+};
+
+// CPU time used so far by every thread of the process, in seconds
+double process_cpu_seconds();
+
+// How much of a core the process used and how busy the GPU was, split between the time the scene
+// was being redrawn and the time it stood still (paused, or nothing moving) and nothing was drawn.
+// GLUT thread only.
+class UtilizationMeter
+{
+public:
+	// Starts timing in the redrawing state. gpu may be null or unavailable, GPU use is left out then.
+	void start(const GpuTimer* gpu);
+
+	// Ends the current period when the state changes
+	void set_still(bool still);
+
+	void print_summary() const;
+
+private:
+	struct Usage
+	{
+		double wall_s = 0.0;
+		double cpu_s = 0.0;
+		double gpu_ms = 0.0;
+	};
+
+	// Usage[still] with the period that is still open added in
+	void totals(Usage out[2]) const;
+
+	const GpuTimer* gpu_timer = nullptr;
+	bool started = false;
+	bool still = false;
+	Usage usage[2]; // Closed periods, [0] redrawing and [1] still
+	Clock::time_point period_start;
+	double period_cpu = 0.0;
+	double period_gpu = 0.0;
+};
@@ -0,0 +1,82 @@
+#include "renderer.h"
+#include "gl_ext.h"
+
+#include <iostream>
+
+void Renderer::init(RenderPath requested)
+{
+	render_path = RENDER_LEGACY;
+	if (requested != RENDER_CORE)
+	{
+		return;
+	}
+
+	if (!gl_ext_has_core())
+	{
+		std::cout << "GL 3.3 core entry points missing, falling back to the legacy renderer\n";
+		return;
+	}
+
+	// Build the sprite program up front so a broken driver is caught before the first frame
+	if (shader_cache.get("sprite") == 0)
+	{
+		std::cout << "Sprite shader unavailable, falling back to the legacy renderer\n";
+		shader_cache.shutdown();
+		return;
+	}
+
+	pglGenBuffers(1, &frame_ubo);
+	pglBindBuffer(GL_UNIFORM_BUFFER, frame_ubo);
+	pglBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+	pglBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	// Bound once, every program reads its Frame block from this binding point
+	pglBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, frame_ubo);
+
+	render_path = RENDER_CORE;
+}
+
+void Renderer::shutdown()
+{
+	if (frame_ubo != 0)
+	{
+		pglDeleteBuffers(1, &frame_ubo);
+		frame_ubo = 0;
+	}
+	shader_cache.shutdown();
+}
+
+void Renderer::begin_frame(const FrameUniforms& uniforms)
+{
+	if (render_path == RENDER_CORE)
+	{
+		pglBindBuffer(GL_UNIFORM_BUFFER, frame_ubo);
+		pglBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &uniforms);
+		pglBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+	else
+	{
+		glMatrixMode(GL_PROJECTION);
+		glLoadMatrixf(uniforms.view_proj);
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+	}
+}
+
+void matrix_identity(float m[16])
+{
+	for (int i = 0; i < 16; ++i)
+	{
+		m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+	}
+}
+
+void matrix_ortho(float left, float right, float bottom, float top, float m[16])
+{
+	matrix_identity(m);
+	m[0] = 2.0f / (right - left);
+	m[5] = 2.0f / (top - bottom);
+	m[10] = -1.0f;
+	m[12] = -(right + left) / (right - left);
+	m[13] = -(top + bottom) / (top - bottom);
+}
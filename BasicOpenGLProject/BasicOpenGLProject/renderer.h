@@ -0,0 +1,56 @@
+#pragma once
+
+#include "shaders.h"
+
+#include <GL/freeglut.h>
+
+//=================================================================================================
+// RENDERER
+//
+// Owns the pieces of GL state that are shared by everything drawn in a frame. The core path
+// (GL 3.3 core functionality) draws with the cached shader programs and a per-frame uniform
+// buffer; the legacy path keeps using the fixed-function pipeline for --legacy-gl, which runs in a
+// compatibility profile.
+//=================================================================================================
+
+enum RenderPath
+{
+	RENDER_LEGACY,
+	RENDER_CORE,
+};
+
+// Mirrors the std140 "Frame" block declared by every built-in shader
+struct FrameUniforms
+{
+	float view_proj[16]; // Column-major
+	float time[4]; // x = seconds since startup
+};
+
+class Renderer
+{
+public:
+	// Needs a current context and gl_ext_load. Asking for the core path on a context that cannot
+	// do it falls back to legacy, check path() afterwards: in a core profile that fallback draws
+	// nothing, so the caller has to give up instead.
+	void init(RenderPath requested);
+	void shutdown();
+
+	// Uploads the frame uniforms (core) or loads the projection matrix (legacy). May be called
+	// again after flushing everything drawn so far, to switch to another projection for overlays.
+	void begin_frame(const FrameUniforms& uniforms);
+
+	RenderPath path() const { return render_path; }
+	ShaderCache& shaders() { return shader_cache; }
+
+private:
+	RenderPath render_path = RENDER_LEGACY;
+	ShaderCache shader_cache;
+	GLuint frame_ubo = 0;
+};
+
+// Fills m with the identity matrix
+void matrix_identity(float m[16]);
+
+// Fills m with an orthographic projection mapping the rectangle onto [-1, 1], like glOrtho with
+// near -1 and far 1
+void matrix_ortho(float left, float right, float bottom, float top, float m[16]);
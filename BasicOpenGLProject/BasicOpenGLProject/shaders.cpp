@@ -0,0 +1,205 @@
+#include "shaders.h"
+#include "gl_ext.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+struct ShaderSource
+{
+	const char* name;
+	const char* vertex;
+	const char* fragment;
+};
+
+#define GLSL_HEADER \
+	"#version 330 core\n" \
+	"layout(std140) uniform Frame\n" \
+	"{\n" \
+	"	mat4 view_proj;\n" \
+	"	vec4 time;\n" \
+	"};\n"
+
+static const ShaderSource BUILTIN_SHADERS[] = {
+	{
+		"sprite",
+		GLSL_HEADER
+		"layout(location = 0) in vec2 position;\n"
+		"layout(location = 1) in vec4 color;\n"
+		"out vec4 v_color;\n"
+		"void main()\n"
+		"{\n"
+		"	v_color = color;\n"
+		"	gl_Position = view_proj * vec4(position, 0.0, 1.0);\n"
+		"}\n",
+
+		"#version 330 core\n"
+		"in vec4 v_color;\n"
+		"out vec4 frag_color;\n"
+		"void main()\n"
+		"{\n"
+		"	frag_color = v_color;\n"
+		"}\n",
+	},
+	{
+		// Same as "sprite", tinted by the texture bound to unit 0
+		"sprite_textured",
+		GLSL_HEADER
+		"layout(location = 0) in vec2 position;\n"
+		"layout(location = 1) in vec4 color;\n"
+		"layout(location = 4) in vec2 texcoord;\n"
+		"out vec4 v_color;\n"
+		"out vec2 v_texcoord;\n"
+		"void main()\n"
+		"{\n"
+		"	v_color = color;\n"
+		"	v_texcoord = texcoord;\n"
+		"	gl_Position = view_proj * vec4(position, 0.0, 1.0);\n"
+		"}\n",
+
+		"#version 330 core\n"
+		"uniform sampler2D sprite_texture;\n"
+		"in vec4 v_color;\n"
+		"in vec2 v_texcoord;\n"
+		"out vec4 frag_color;\n"
+		"void main()\n"
+		"{\n"
+		"	frag_color = v_color * texture(sprite_texture, v_texcoord);\n"
+		"}\n",
+	},
+	{
+		// Unit shape per vertex, placement and colour per instance
+		"sprite_instanced",
+		GLSL_HEADER
+		"layout(location = 0) in vec2 position;\n"
+		"layout(location = 1) in vec4 color;\n"
+		"layout(location = 2) in vec2 offset;\n"
+		"layout(location = 3) in vec2 size;\n"
+		"out vec4 v_color;\n"
+		"void main()\n"
+		"{\n"
+		"	v_color = color;\n"
+		"	gl_Position = view_proj * vec4(offset + position * size, 0.0, 1.0);\n"
+		"}\n",
+
+		"#version 330 core\n"
+		"in vec4 v_color;\n"
+		"out vec4 frag_color;\n"
+		"void main()\n"
+		"{\n"
+		"	frag_color = v_color;\n"
+		"}\n",
+	},
+};
+
+static GLuint compile(GLenum type, const char* source, const char* name)
+{
+	GLuint shader = pglCreateShader(type);
+	pglShaderSource(shader, 1, &source, nullptr);
+	pglCompileShader(shader);
+
+	GLint ok = 0;
+	pglGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok)
+	{
+		GLint length = 0;
+		pglGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		std::vector<GLchar> log(length > 1 ? length : 1);
+		pglGetShaderInfoLog(shader, static_cast<GLsizei>(log.size()), nullptr, log.data());
+		std::cout << "Shader " << name << (type == GL_VERTEX_SHADER ? " (vertex)" : " (fragment)") << " failed to compile:\n" << log.data() << "\n";
+
+		pglDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static GLuint build(const ShaderSource& source)
+{
+	GLuint vertex = compile(GL_VERTEX_SHADER, source.vertex, source.name);
+	GLuint fragment = compile(GL_FRAGMENT_SHADER, source.fragment, source.name);
+	if (!vertex || !fragment)
+	{
+		if (vertex) pglDeleteShader(vertex);
+		if (fragment) pglDeleteShader(fragment);
+		return 0;
+	}
+
+	GLuint program = pglCreateProgram();
+	pglAttachShader(program, vertex);
+	pglAttachShader(program, fragment);
+	pglLinkProgram(program);
+
+	// The program keeps the compiled code, the shader objects are no longer needed
+	pglDeleteShader(vertex);
+	pglDeleteShader(fragment);
+
+	GLint ok = 0;
+	pglGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if (!ok)
+	{
+		GLint length = 0;
+		pglGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		std::vector<GLchar> log(length > 1 ? length : 1);
+		pglGetProgramInfoLog(program, static_cast<GLsizei>(log.size()), nullptr, log.data());
+		std::cout << "Program " << source.name << " failed to link:\n" << log.data() << "\n";
+
+		pglDeleteProgram(program);
+		return 0;
+	}
+
+	GLuint block = pglGetUniformBlockIndex(program, "Frame");
+	if (block != GL_INVALID_INDEX)
+	{
+		pglUniformBlockBinding(program, block, FRAME_UNIFORM_BINDING);
+	}
+
+	return program;
+}
+
+GLuint ShaderCache::get(const char* name)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (std::strcmp(entries[i].name, name) == 0)
+		{
+			return entries[i].program;
+		}
+	}
+
+	for (const ShaderSource& source : BUILTIN_SHADERS)
+	{
+		if (std::strcmp(source.name, name) == 0 && count < MAX_PROGRAMS)
+		{
+			// Failures are cached as 0 too so a broken shader is only reported once
+			GLuint program = build(source);
+			entries[count++] = { source.name, program };
+			return program;
+		}
+	}
+
+	std::cout << "Unknown shader " << name << "\n";
+	return 0;
+}
+
+void ShaderCache::use(GLuint program)
+{
+	if (program != current)
+	{
+		pglUseProgram(program);
+		current = program;
+	}
+}
+
+void ShaderCache::shutdown()
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (entries[i].program)
+		{
+			pglDeleteProgram(entries[i].program);
+		}
+	}
+	count = 0;
+	current = 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <GL/freeglut.h>
+
+//=================================================================================================
+// SHADERS
+//
+// Built-in GLSL 3.30 programs, compiled and linked the first time they are asked for and cached by
+// name afterwards. Every program's "Frame" uniform block is bound to FRAME_UNIFORM_BINDING, so
+// the per-frame uniform buffer is bound once per frame no matter how many programs use it.
+//=================================================================================================
+
+const GLuint FRAME_UNIFORM_BINDING = 0;
+
+// Attribute locations shared by all built-in vertex shaders
+const GLuint ATTRIB_POSITION = 0;
+const GLuint ATTRIB_COLOR = 1;
+const GLuint ATTRIB_INSTANCE_OFFSET = 2; // Per instance, centre of the sprite
+const GLuint ATTRIB_INSTANCE_SIZE = 3; // Per instance, scales the unit shape
+const GLuint ATTRIB_TEXCOORD = 4;
+
+class ShaderCache
+{
+public:
+	// Linked program for a built-in shader, 0 if it does not exist or failed to build
+	GLuint get(const char* name);
+
+	// glUseProgram, skipped when the program is already current
+	void use(GLuint program);
+
+	void shutdown();
+
+private:
+	static const int MAX_PROGRAMS = 16;
+
+	struct Entry
+	{
+		const char* name;
+		GLuint program;
+	};
+
+	Entry entries[MAX_PROGRAMS] = {};
+	int count = 0;
+	GLuint current = 0;
+};
@@ -0,0 +1,92 @@
+#include "snapshot.h"
+
+#include <algorithm>
+
+void snapshot_buffer_init(SnapshotBuffer& buffer, size_t max_entities, size_t max_effects, size_t max_particles)
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		RenderSnapshot& snapshot = buffer.slot(i);
+		snapshot.entities.reserve(max_entities);
+		snapshot.effects.resize(max_effects);
+		snapshot.effect_count = 0;
+		snapshot.particles.init(max_particles);
+	}
+}
+
+// True when any entity is somewhere else than it was a tick earlier
+static bool entities_moved(const EntityStore& entities)
+{
+	const size_t n = entities.size();
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (entities.pos_x[i] != entities.prev_x[i] || entities.pos_y[i] != entities.prev_y[i])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void capture_snapshot(RenderSnapshot& out, const EntityStore& entities, const ObjectPool<Effect>* effects,
+	const ParticleSystem* particles, const Camera* camera, const Camera* prev_camera, std::uint32_t tick, float alpha)
+{
+	out.camera = camera ? *camera : Camera();
+	out.prev_camera = prev_camera ? *prev_camera : out.camera;
+
+	// Everything either camera position can see
+	Aabb view = camera_view(out.camera, SNAPSHOT_CULL_MARGIN);
+	Aabb prev_view = camera_view(out.prev_camera, SNAPSHOT_CULL_MARGIN);
+	view.min_x = std::min(view.min_x, prev_view.min_x);
+	view.min_y = std::min(view.min_y, prev_view.min_y);
+	view.max_x = std::max(view.max_x, prev_view.max_x);
+	view.max_y = std::max(view.max_y, prev_view.max_y);
+
+	if (camera)
+	{
+		out.entities.copy_for_render(entities, view);
+	}
+	else
+	{
+		out.entities.copy_for_render(entities);
+	}
+
+	out.effect_count = 0;
+	if (effects)
+	{
+		// Explosions grow to 0.1 either side of their centre
+		effects->for_each([&out, &view](const Effect& effect)
+		{
+			if (out.effect_count < out.effects.size() && box_in_view(view, effect.x, effect.y, 0.1f, 0.1f))
+			{
+				out.effects[out.effect_count++] = effect;
+			}
+		});
+	}
+
+	if (particles && camera)
+	{
+		out.particles.copy_for_render(*particles, view);
+	}
+	else if (particles)
+	{
+		out.particles.copy_for_render(*particles);
+	}
+	else
+	{
+		out.particles.clear();
+	}
+
+	out.tick = tick;
+	out.alpha = alpha;
+	out.taken = Clock::now();
+	out.still = out.effect_count == 0 && out.particles.size() == 0 && !entities_moved(out.entities)
+		&& out.camera.x == out.prev_camera.x && out.camera.y == out.prev_camera.y;
+}
+
+float snapshot_alpha(const RenderSnapshot& snapshot, Clock::time_point now)
+{
+	float since = std::chrono::duration<float>(now - snapshot.taken).count() / TICK_DT;
+	float alpha = snapshot.alpha + since;
+	return alpha < 1.0f ? alpha : 1.0f;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "camera.h"
+#include "entities.h"
+#include "game.h"
+#include "game_loop.h"
+#include "triple_buffer.h"
+
+#include <vector>
+
+//=================================================================================================
+// RENDER SNAPSHOTS
+//
+// The renderer never reads the live simulation. After its ticks the simulation copies what
+// display_func needs into a snapshot and publishes it through a triple buffer, so with --sim-thread
+// the next ticks run on their own thread while the GLUT thread draws the last snapshot. Only what
+// the camera can see goes into it, so nothing off-screen is ever copied or submitted.
+//=================================================================================================
+
+struct RenderSnapshot
+{
+	EntityStore entities; // Render copy, see EntityStore::copy_for_render
+	std::vector<Effect> effects; // The first effect_count are live
+	size_t effect_count = 0;
+	ParticleSystem particles;
+	Camera camera;
+	Camera prev_camera; // A tick earlier, drawn between the two like the entities
+	std::uint32_t tick = 0; // Ticks simulated when it was taken
+	std::uint32_t score = 0; // For the HUD
+	int player_hits = 0;
+	float alpha = 0.0f; // Time left over in the fixed timestep when it was taken, in ticks
+	Clock::time_point taken;
+	bool still = false; // Nothing moves or animates, every frame drawn from it looks the same
+};
+
+typedef TripleBuffer<RenderSnapshot> SnapshotBuffer;
+
+// Sizes all three slots so capturing never allocates
+void snapshot_buffer_init(SnapshotBuffer& buffer, size_t max_entities, size_t max_effects, size_t max_particles);
+
+// How far outside the view entities are still copied. Covers anything moving for a tick, so both
+// ends of the interpolation are checked by testing the newest position.
+const float SNAPSHOT_CULL_MARGIN = 0.1f;
+
+// Copies entities and (optionally) effects and particles into the producer's slot and works out
+// whether it is still; publish it afterwards. With a camera (current and a tick earlier) only what
+// it can see is copied, without one everything is and the view is the [-1, 1] field.
+void capture_snapshot(RenderSnapshot& out, const EntityStore& entities, const ObjectPool<Effect>* effects,
+	const ParticleSystem* particles, const Camera* camera, const Camera* prev_camera, std::uint32_t tick, float alpha);
+
+// Interpolation factor for drawing a snapshot at time now. Keeps advancing after the snapshot was
+// taken so motion stays smooth while the next one is being simulated, capped at the next tick.
+float snapshot_alpha(const RenderSnapshot& snapshot, Clock::time_point now);
@@ -0,0 +1,133 @@
+#include "spatial_grid.h"
+
+const std::uint32_t SpatialGrid::NO_CELL;
+const std::uint32_t SpatialGrid::NONE;
+
+void SpatialGrid::init(float min_x, float min_y, float max_x, float max_y, int grid_cols, int grid_rows, size_t max_ids)
+{
+	origin_x = min_x;
+	origin_y = min_y;
+	cols = grid_cols;
+	rows = grid_rows;
+	inv_cell_w = cols / (max_x - min_x);
+	inv_cell_h = rows / (max_y - min_y);
+
+	head.assign(static_cast<size_t>(cols) * rows, NONE);
+	next.assign(max_ids, NONE);
+	prev.assign(max_ids, NONE);
+	cell_of.assign(max_ids, NO_CELL);
+
+	max_half_w = 0.0f;
+	max_half_h = 0.0f;
+	count = 0;
+}
+
+void SpatialGrid::clear()
+{
+	head.assign(head.size(), NONE);
+	cell_of.assign(cell_of.size(), NO_CELL);
+	count = 0;
+}
+
+// Anything outside the grid is kept in the border cells
+int SpatialGrid::column(float x) const
+{
+	int c = static_cast<int>((x - origin_x) * inv_cell_w);
+	return c < 0 ? 0 : (c >= cols ? cols - 1 : c);
+}
+
+int SpatialGrid::row(float y) const
+{
+	int r = static_cast<int>((y - origin_y) * inv_cell_h);
+	return r < 0 ? 0 : (r >= rows ? rows - 1 : r);
+}
+
+void SpatialGrid::link(std::uint32_t id, std::uint32_t cell)
+{
+	cell_of[id] = cell;
+	prev[id] = NONE;
+	next[id] = head[cell];
+	if (head[cell] != NONE)
+	{
+		prev[head[cell]] = id;
+	}
+	head[cell] = id;
+}
+
+void SpatialGrid::unlink(std::uint32_t id)
+{
+	std::uint32_t cell = cell_of[id];
+	if (prev[id] != NONE)
+	{
+		next[prev[id]] = next[id];
+	}
+	else
+	{
+		head[cell] = next[id];
+	}
+	if (next[id] != NONE)
+	{
+		prev[next[id]] = prev[id];
+	}
+	cell_of[id] = NO_CELL;
+}
+
+void SpatialGrid::insert(std::uint32_t id, float x, float y, float half_w, float half_h)
+{
+	if (contains(id))
+	{
+		unlink(id);
+		count--;
+	}
+
+	if (half_w > max_half_w) max_half_w = half_w;
+	if (half_h > max_half_h) max_half_h = half_h;
+
+	link(id, cell_at(x, y));
+	count++;
+}
+
+void SpatialGrid::move(std::uint32_t id, float x, float y)
+{
+	std::uint32_t cell = cell_at(x, y);
+	if (cell != cell_of[id])
+	{
+		unlink(id);
+		link(id, cell);
+	}
+}
+
+void SpatialGrid::remove(std::uint32_t id)
+{
+	if (contains(id))
+	{
+		unlink(id);
+		count--;
+	}
+}
+
+size_t SpatialGrid::query(float min_x, float min_y, float max_x, float max_y, std::uint32_t* out, size_t max_out) const
+{
+	// An id is filed under its centre, so widen by the largest extent to catch boxes poking in
+	int c0 = column(min_x - max_half_w);
+	int c1 = column(max_x + max_half_w);
+	int r0 = row(min_y - max_half_h);
+	int r1 = row(max_y + max_half_h);
+
+	size_t written = 0;
+	for (int r = r0; r <= r1; ++r)
+	{
+		for (int c = c0; c <= c1; ++c)
+		{
+			for (std::uint32_t id = head[r * cols + c]; id != NONE; id = next[id])
+			{
+				if (written == max_out)
+				{
+					return written;
+				}
+				out[written++] = id;
+			}
+		}
+	}
+	return written;
+}
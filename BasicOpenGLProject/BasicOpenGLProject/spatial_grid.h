@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//=================================================================================================
+// SPATIAL GRID
+//
+// Uniform grid over a fixed rectangle of the world (the [-1, 1] play field by default). Each id
+// sits in the cell holding its centre, linked into that cell's intrusive list, so moving an id
+// only costs anything when it actually crosses into another cell. Queries widen the rectangle by
+// the largest extent ever inserted and return every id from the cells it touches; the exact
+// overlap test is left to the caller.
+//=================================================================================================
+
+class SpatialGrid
+{
+public:
+	// ids passed to the other functions must be below max_ids
+	void init(float min_x, float min_y, float max_x, float max_y, int cols, int rows, size_t max_ids);
+
+	void clear();
+
+	void insert(std::uint32_t id, float x, float y, float half_w, float half_h);
+
+	// Relinks the id only if its centre moved into another cell
+	void move(std::uint32_t id, float x, float y);
+
+	void remove(std::uint32_t id);
+
+	bool contains(std::uint32_t id) const { return id < cell_of.size() && cell_of[id] != NO_CELL; }
+
+	// Writes up to max_out candidate ids that may overlap the rectangle, returns how many were written
+	size_t query(float min_x, float min_y, float max_x, float max_y, std::uint32_t* out, size_t max_out) const;
+
+	size_t size() const { return count; }
+
+private:
+	static const std::uint32_t NO_CELL = 0xFFFFFFFFu;
+	static const std::uint32_t NONE = 0xFFFFFFFFu;
+
+	int column(float x) const;
+	int row(float y) const;
+	std::uint32_t cell_at(float x, float y) const { return static_cast<std::uint32_t>(row(y) * cols + column(x)); }
+
+	void link(std::uint32_t id, std::uint32_t cell);
+	void unlink(std::uint32_t id);
+
+	float origin_x = -1.0f, origin_y = -1.0f;
+	float inv_cell_w = 1.0f, inv_cell_h = 1.0f;
+	int cols = 1, rows = 1;
+	float max_half_w = 0.0f, max_half_h = 0.0f;
+	size_t count = 0;
+
+	std::vector<std::uint32_t> head; // First id in each cell
+	std::vector<std::uint32_t> next; // Per id
+	std::vector<std::uint32_t> prev; // Per id
+	std::vector<std::uint32_t> cell_of; // Per id, NO_CELL when not in the grid
+};
@@ -0,0 +1,271 @@
+#include "sprite_batch.h"
+#include "gl_ext.h"
+
+#include <algorithm>
+#include <cstddef>
+
+void SpriteBatch::init(size_t max_vertices, ShaderCache* shaders)
+{
+	capacity = max_vertices;
+	for (Run& run : runs)
+	{
+		run.vertices.reserve(capacity);
+	}
+
+	if (gl_ext_has_vbo())
+	{
+		pglGenBuffers(1, &vbo);
+	}
+
+	if (shaders && vbo != 0)
+	{
+		shader_cache = shaders;
+		program = shaders->get("sprite");
+		textured_program = shaders->get("sprite_textured");
+
+		// The attribute layout never changes, so it is recorded in the VAO once and only the
+		// buffer contents are replaced every frame
+		const GLsizei stride = sizeof(SpriteVertex);
+		pglGenVertexArrays(1, &vao);
+		pglBindVertexArray(vao);
+		pglBindBuffer(GL_ARRAY_BUFFER, vbo);
+		pglEnableVertexAttribArray(ATTRIB_POSITION);
+		pglVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(SpriteVertex, x)));
+		pglEnableVertexAttribArray(ATTRIB_COLOR);
+		pglVertexAttribPointer(ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(SpriteVertex, color)));
+		pglEnableVertexAttribArray(ATTRIB_TEXCOORD);
+		pglVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(SpriteVertex, u)));
+		pglBindVertexArray(0);
+		pglBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+void SpriteBatch::shutdown()
+{
+	if (vao != 0)
+	{
+		pglDeleteVertexArrays(1, &vao);
+		vao = 0;
+	}
+	if (vbo != 0)
+	{
+		pglDeleteBuffers(1, &vbo);
+		vbo = 0;
+	}
+	shader_cache = nullptr;
+	program = 0;
+	textured_program = 0;
+}
+
+void SpriteBatch::begin()
+{
+	run_count = 0;
+	frame_stats = BatchStats();
+}
+
+SpriteBatch::Run& SpriteBatch::run_for(const Material& material, size_t needed)
+{
+	for (int i = 0; i < run_count; ++i)
+	{
+		if (runs[i].material == material)
+		{
+			if (runs[i].vertices.size() + needed <= capacity)
+			{
+				return runs[i];
+			}
+
+			// Full run: draw what we have so far and start over rather than growing the vector
+			flush();
+			break;
+		}
+	}
+
+	if (run_count == MAX_MATERIALS)
+	{
+		flush();
+	}
+
+	Run& run = runs[run_count++];
+	run.material = material;
+	run.vertices.clear();
+	return run;
+}
+
+void SpriteBatch::add_triangle(float x0, float y0, float x1, float y1, float x2, float y2, Color color, Material material)
+{
+	Run& run = run_for(material, 3);
+	run.vertices.push_back({ x0, y0, 0.0f, 0.0f, color });
+	run.vertices.push_back({ x1, y1, 0.0f, 0.0f, color });
+	run.vertices.push_back({ x2, y2, 0.0f, 0.0f, color });
+}
+
+void SpriteBatch::add_quad(float x, float y, float w, float h, Color color, Material material)
+{
+	add_sprite(x, y, w, h, { 0.0f, 0.0f, 0.0f, 0.0f }, color, material);
+}
+
+void SpriteBatch::add_sprite(float x, float y, float w, float h, const UvRect& uv, Color color, Material material)
+{
+	// y grows upwards on screen but rows go downwards in the image, so the bottom edge gets v1
+	Run& run = run_for(material, 6);
+	run.vertices.push_back({ x, y, uv.u0, uv.v1, color });
+	run.vertices.push_back({ x + w, y, uv.u1, uv.v1, color });
+	run.vertices.push_back({ x + w, y + h, uv.u1, uv.v0, color });
+	run.vertices.push_back({ x, y, uv.u0, uv.v1, color });
+	run.vertices.push_back({ x + w, y + h, uv.u1, uv.v0, color });
+	run.vertices.push_back({ x, y + h, uv.u0, uv.v0, color });
+}
+
+void SpriteBatch::add_vertices(const SpriteVertex* vertices, size_t count, Material material)
+{
+	// Whole quads at a time, so anything larger than a run is split between triangles
+	const size_t chunk = capacity / 6 * 6;
+	while (count > 0)
+	{
+		size_t n = std::min(count, chunk);
+		Run& run = run_for(material, n);
+		run.vertices.insert(run.vertices.end(), vertices, vertices + n);
+		vertices += n;
+		count -= n;
+	}
+}
+
+void SpriteBatch::flush()
+{
+	if (run_count == 0)
+	{
+		return;
+	}
+
+	draw_runs();
+	run_count = 0;
+}
+
+void SpriteBatch::upload_runs()
+{
+	const GLsizei stride = sizeof(SpriteVertex);
+
+	size_t total = 0;
+	for (int i = 0; i < run_count; ++i)
+	{
+		total += runs[i].vertices.size();
+	}
+
+	// Orphan the previous storage so the driver never waits on last frame's draws
+	pglBindBuffer(GL_ARRAY_BUFFER, vbo);
+	pglBufferData(GL_ARRAY_BUFFER, total * stride, nullptr, GL_STREAM_DRAW);
+
+	size_t offset = 0;
+	for (int i = 0; i < run_count; ++i)
+	{
+		const std::vector<SpriteVertex>& vertices = runs[i].vertices;
+		pglBufferSubData(GL_ARRAY_BUFFER, offset * stride, vertices.size() * stride, vertices.data());
+		offset += vertices.size();
+	}
+	frame_stats.uploads++;
+}
+
+void SpriteBatch::draw_runs()
+{
+	const GLsizei stride = sizeof(SpriteVertex);
+
+	if (vao != 0)
+	{
+		upload_runs();
+		pglBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		pglBindVertexArray(vao);
+
+		GLint first = 0;
+		for (int i = 0; i < run_count; ++i)
+		{
+			const Material& material = runs[i].material;
+			GLsizei count = static_cast<GLsizei>(runs[i].vertices.size());
+
+			// A shader that failed to build was already reported by the cache, just skip its runs
+			GLuint run_program = material.texture != 0 ? textured_program : program;
+			if (run_program != 0)
+			{
+				shader_cache->use(run_program);
+				bind_texture(material.texture);
+				glDrawArrays(material.primitive, first, count);
+				frame_stats.draw_calls++;
+				frame_stats.vertices += count;
+			}
+			first += count;
+		}
+
+		pglBindVertexArray(0);
+		bind_texture(0);
+		return;
+	}
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	if (vbo != 0)
+	{
+		upload_runs();
+
+		glVertexPointer(2, GL_FLOAT, stride, reinterpret_cast<const void*>(offsetof(SpriteVertex, x)));
+		glColorPointer(4, GL_UNSIGNED_BYTE, stride, reinterpret_cast<const void*>(offsetof(SpriteVertex, color)));
+		glTexCoordPointer(2, GL_FLOAT, stride, reinterpret_cast<const void*>(offsetof(SpriteVertex, u)));
+
+		GLint first = 0;
+		for (int i = 0; i < run_count; ++i)
+		{
+			GLsizei count = static_cast<GLsizei>(runs[i].vertices.size());
+			bind_texture(runs[i].material.texture);
+			glDrawArrays(runs[i].material.primitive, first, count);
+			first += count;
+			frame_stats.draw_calls++;
+			frame_stats.vertices += count;
+		}
+
+		pglBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	else
+	{
+		// No buffer objects: point straight at the runs in client memory
+		for (int i = 0; i < run_count; ++i)
+		{
+			const std::vector<SpriteVertex>& vertices = runs[i].vertices;
+			glVertexPointer(2, GL_FLOAT, stride, &vertices[0].x);
+			glColorPointer(4, GL_UNSIGNED_BYTE, stride, &vertices[0].color);
+			glTexCoordPointer(2, GL_FLOAT, stride, &vertices[0].u);
+			bind_texture(runs[i].material.texture);
+			glDrawArrays(runs[i].material.primitive, 0, static_cast<GLsizei>(vertices.size()));
+			frame_stats.draw_calls++;
+			frame_stats.vertices += static_cast<unsigned>(vertices.size());
+		}
+	}
+
+	bind_texture(0);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void SpriteBatch::bind_texture(GLuint texture)
+{
+	if (texture == bound_texture)
+	{
+		return;
+	}
+
+	// Fixed function only samples while GL_TEXTURE_2D is enabled, core just needs the binding
+	if (vao == 0 && (texture == 0) != (bound_texture == 0))
+	{
+		if (texture != 0)
+		{
+			glEnable(GL_TEXTURE_2D);
+		}
+		else
+		{
+			glDisable(GL_TEXTURE_2D);
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+	bound_texture = texture;
+}
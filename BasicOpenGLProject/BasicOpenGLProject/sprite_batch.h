@@ -0,0 +1,103 @@
+#pragma once
+
+#include "shaders.h"
+
+#include <GL/freeglut.h>
+#include <vector>
+
+//=================================================================================================
+// SPRITE BATCH
+//
+// Collects every triangle of a frame into per-material vertex runs and submits them all from one
+// streaming vertex buffer, so the number of draw calls depends on the number of materials in the
+// frame rather than on the number of entities. Given a shader cache the batch draws through a
+// vertex array object and the "sprite" program (GL 3.3 core); without one it uses client state.
+//=================================================================================================
+
+struct Color
+{
+	unsigned char r, g, b, a;
+};
+
+// Texture coordinates of a sprite, v0 is the top row of the image
+struct UvRect
+{
+	float u0, v0, u1, v1;
+};
+
+struct SpriteVertex
+{
+	float x, y;
+	float u, v;
+	Color color;
+};
+
+// Everything that forces a separate draw call
+struct Material
+{
+	GLenum primitive = GL_TRIANGLES;
+	GLuint texture = 0; // 0 = flat colour
+
+	bool operator==(const Material& other) const
+	{
+		return primitive == other.primitive && texture == other.texture;
+	}
+};
+
+struct BatchStats
+{
+	unsigned draw_calls = 0;
+	unsigned vertices = 0;
+	unsigned uploads = 0;
+};
+
+class SpriteBatch
+{
+public:
+	static const int MAX_MATERIALS = 8;
+
+	// Reserves room for max_vertices per material and creates the vertex buffer. Pass the
+	// renderer's shader cache on the core path, nullptr for the fixed-function path.
+	void init(size_t max_vertices, ShaderCache* shaders = nullptr);
+	void shutdown();
+
+	// Starts a new frame and clears the per-frame statistics
+	void begin();
+
+	void add_triangle(float x0, float y0, float x1, float y1, float x2, float y2, Color color, Material material = Material());
+	void add_quad(float x, float y, float w, float h, Color color, Material material = Material());
+
+	// Textured quad; material.texture must be the texture uv refers to, color tints it
+	void add_sprite(float x, float y, float w, float h, const UvRect& uv, Color color, Material material);
+
+	// Triangles laid out ahead of time, e.g. a TextRun; count is a multiple of three
+	void add_vertices(const SpriteVertex* vertices, size_t count, Material material);
+
+	// Uploads all runs with a single buffer orphan and issues one draw call per material
+	void flush();
+
+	const BatchStats& stats() const { return frame_stats; }
+
+private:
+	struct Run
+	{
+		Material material;
+		std::vector<SpriteVertex> vertices;
+	};
+
+	Run& run_for(const Material& material, size_t needed);
+	void upload_runs();
+	void draw_runs();
+	void bind_texture(GLuint texture);
+
+	Run runs[MAX_MATERIALS];
+	int run_count = 0;
+	size_t capacity = 0;
+	GLuint vbo = 0;
+	GLuint vao = 0;
+	ShaderCache* shader_cache = nullptr;
+	GLuint program = 0;
+	GLuint textured_program = 0;
+	GLuint bound_texture = 0;
+	BatchStats frame_stats;
+};
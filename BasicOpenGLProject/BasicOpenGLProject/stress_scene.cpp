@@ -0,0 +1,51 @@
+#include "stress_scene.h"
+
+#include <random>
+
+void StressScene::init(size_t count, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> pos(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> vel(-0.3f, 0.3f);
+	std::uniform_real_distribution<float> size(0.004f, 0.012f);
+
+	entities.clear();
+	entities.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		float half = size(rng);
+		entities.create(KIND_ENEMY, pos(rng), pos(rng), vel(rng), vel(rng), half, half);
+	}
+}
+
+void StressScene::update(float dt, JobSystem* jobs)
+{
+	EntityStore& store = entities;
+	auto step = [&store, dt](size_t begin, size_t end, int)
+	{
+		store.update_range(dt, begin, end);
+
+		// Wrap around, and skip interpolation for whatever just wrapped so it does not streak across
+		for (size_t i = begin; i < end; ++i)
+		{
+			float x = store.pos_x[i];
+			float y = store.pos_y[i];
+			if (x < -1.0f || x > 1.0f || y < -1.0f || y > 1.0f)
+			{
+				x = x < -1.0f ? x + 2.0f : (x > 1.0f ? x - 2.0f : x);
+				y = y < -1.0f ? y + 2.0f : (y > 1.0f ? y - 2.0f : y);
+				store.pos_x[i] = store.prev_x[i] = x;
+				store.pos_y[i] = store.prev_y[i] = y;
+			}
+		}
+	};
+
+	if (jobs)
+	{
+		jobs->parallel_for(entities.size(), 4096, step);
+	}
+	else
+	{
+		step(0, entities.size(), 0);
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "entities.h"
+#include "jobs.h"
+
+//=================================================================================================
+// STRESS SCENE
+//
+// --stress N replaces the game with N enemies drifting across the screen and wrapping at the
+// edges. Nothing collides; it exists to measure how many sprites the renderer can draw.
+//=================================================================================================
+
+class StressScene
+{
+public:
+	void init(size_t count, unsigned seed);
+	// Splits the work over jobs when given
+	void update(float dt, JobSystem* jobs = nullptr);
+
+	size_t size() const { return entities.size(); }
+
+	EntityStore entities;
+};
@@ -0,0 +1,80 @@
+#include "trace.h"
+
+#include <atomic>
+
+std::uint32_t trace_thread_id()
+{
+	static std::atomic<std::uint32_t> next_id(1);
+	thread_local std::uint32_t id = next_id++;
+	return id;
+}
+
+bool TraceWriter::open(const std::string& path, size_t max_events)
+{
+	file = std::fopen(path.c_str(), "w");
+	if (!file)
+	{
+		return false;
+	}
+
+	std::fputs("[\n", file);
+	first_event = true;
+	origin = Clock::now();
+	events.reserve(max_events);
+	capacity = max_events;
+	dropped_events = 0;
+	return true;
+}
+
+void TraceWriter::close()
+{
+	if (!file)
+	{
+		return;
+	}
+
+	flush();
+	std::fputs("\n]\n", file);
+	std::fclose(file);
+	file = nullptr;
+}
+
+void TraceWriter::span(const char* name, Clock::time_point start, Clock::time_point end)
+{
+	Event event;
+	event.name = name;
+	event.start_us = std::chrono::duration_cast<std::chrono::microseconds>(start - origin).count();
+	event.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	event.thread = trace_thread_id();
+
+	std::lock_guard<std::mutex> guard(lock);
+
+	// Never grow the buffer mid-frame, just count what we lose until the next flush
+	if (events.size() == capacity)
+	{
+		dropped_events++;
+		return;
+	}
+	events.push_back(event);
+}
+
+bool TraceWriter::flush()
+{
+	if (!file)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(lock);
+
+	for (const Event& event : events)
+	{
+		std::fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%u}",
+			first_event ? "" : ",\n", event.name,
+			static_cast<long long>(event.start_us), static_cast<long long>(event.duration_us), event.thread);
+		first_event = false;
+	}
+	events.clear();
+
+	return std::fflush(file) == 0;
+}
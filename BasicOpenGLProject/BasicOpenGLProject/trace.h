@@ -0,0 +1,85 @@
+#pragma once
+
+#include "game_loop.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//=================================================================================================
+// TRACE
+//
+// Records timed spans into a preallocated in-memory buffer and writes them out as Chrome
+// trace_event JSON (chrome://tracing, ui.perfetto.dev) only when flushed, so tracing costs a
+// couple of clock reads per span while the game runs. Each flush appends to the file; the closing
+// bracket is written by close(), and viewers accept files that were flushed but never closed.
+//=================================================================================================
+
+class TraceWriter
+{
+public:
+	// Opens the output file and reserves room for max_events spans between flushes
+	bool open(const std::string& path, size_t max_events);
+
+	// Writes buffered events and the closing bracket
+	void close();
+
+	bool enabled() const { return file != nullptr; }
+
+	// Adds a complete ("X") event. name must outlive the writer (string literals).
+	void span(const char* name, Clock::time_point start, Clock::time_point end);
+
+	// Appends everything buffered so far to the file and empties the buffer
+	bool flush();
+
+	size_t dropped() const { return dropped_events; }
+
+private:
+	struct Event
+	{
+		const char* name;
+		std::int64_t start_us;
+		std::int64_t duration_us;
+		std::uint32_t thread;
+	};
+
+	std::FILE* file = nullptr;
+	bool first_event = true;
+	Clock::time_point origin;
+	std::vector<Event> events;
+	size_t capacity = 0;
+	size_t dropped_events = 0;
+	std::mutex lock; // Spans may come from more than one thread
+};
+
+// Small stable number for the calling thread, used as the trace tid
+std::uint32_t trace_thread_id();
+
+// Times its own lifetime as a span, does nothing when the writer is disabled
+class TraceScope
+{
+public:
+	TraceScope(TraceWriter& writer, const char* name) : writer(writer), name(name)
+	{
+		if (writer.enabled())
+		{
+			start = Clock::now();
+		}
+	}
+
+	~TraceScope()
+	{
+		if (writer.enabled())
+		{
+			writer.span(name, start, Clock::now());
+		}
+	}
+
+private:
+	TraceWriter& writer;
+	const char* name;
+	Clock::time_point start;
+};
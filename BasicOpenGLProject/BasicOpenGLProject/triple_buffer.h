@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+
+//=================================================================================================
+// TRIPLE BUFFER
+//
+// Hands whole values from one producer thread to one consumer thread without locks. The producer
+// always has a slot of its own to write, the consumer always has a slot of its own to read, and
+// the third slot sits in the middle holding the newest finished value. Publishing and acquiring
+// are a single atomic exchange each, so neither side ever waits for the other; the consumer simply
+// sees the latest value that was published, skipping any it was too slow for.
+//=================================================================================================
+
+template <typename T>
+class TripleBuffer
+{
+public:
+	// Producer: the slot to fill in. Still holds whatever was in it last time it was written.
+	T& write_slot() { return slots[write_index]; }
+
+	// Producer: makes the write slot the newest value and takes the old middle slot to write next
+	void publish()
+	{
+		unsigned previous = middle.exchange(write_index | FRESH, std::memory_order_acq_rel);
+		write_index = previous & INDEX_MASK;
+	}
+
+	// Consumer: the newest published value, or the one it already had if nothing new arrived
+	const T& acquire()
+	{
+		if (middle.load(std::memory_order_relaxed) & FRESH)
+		{
+			unsigned previous = middle.exchange(read_index, std::memory_order_acq_rel);
+			read_index = previous & INDEX_MASK;
+		}
+		return slots[read_index];
+	}
+
+	// Either side may size all three slots before the threads start
+	T& slot(int i) { return slots[i]; }
+
+private:
+	static const unsigned INDEX_MASK = 3;
+	static const unsigned FRESH = 4; // Set in middle when it holds a value the consumer has not seen
+
+	T slots[3];
+	unsigned write_index = 0;
+	unsigned read_index = 1;
+	std::atomic<unsigned> middle{ 2 };
+};
@@ -0,0 +1,331 @@
+#include "collision_kernel.h"
+#include "entities.h"
+#include "entity_sprites.h"
+#include "font.h"
+#include "game.h"
+#include "game_loop.h"
+#include "instanced_batch.h"
+#include "offscreen.h"
+#include "particles.h"
+#include "renderer.h"
+#include "sprite_batch.h"
+#include "stress_scene.h"
+
+#ifdef BENCH_HAS_EGL
+#include "headless_gl.h"
+#endif
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//=================================================================================================
+// BENCH
+//
+// Google Benchmark versions of the hot paths: entity update, collision, building the per-frame
+// batches and submitting them to GL. Run with --benchmark_format=json (or the bench_json target)
+// to get results that can be diffed across commits. Render benchmarks are skipped when no
+// headless context can be created.
+//=================================================================================================
+
+#ifndef BENCH_ASSET_DIR
+#define BENCH_ASSET_DIR "assets"
+#endif
+
+//=================================================================================================
+// SIMULATION
+//=================================================================================================
+
+static void BM_EntityUpdate(benchmark::State& state)
+{
+	StressScene scene;
+	scene.init(static_cast<size_t>(state.range(0)), 1234);
+	for (auto _ : state)
+	{
+		scene.entities.update(TICK_DT);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EntityUpdate)->Arg(1000)->Arg(10000)->Arg(100000);
+
+static void BM_CollisionKernel(benchmark::State& state)
+{
+	typedef size_t (*OverlapFn)(const Aabb&, const AabbBatch&, std::uint8_t*);
+	const OverlapFn kernels[] = { overlap_aabb_scalar, overlap_aabb_sse, overlap_aabb_avx2 };
+	const bool available[] = { true, cpu_has_sse2(), cpu_has_avx2() };
+	const int which = static_cast<int>(state.range(0));
+	if (!available[which])
+	{
+		state.SkipWithError("not supported on this CPU");
+		return;
+	}
+
+	const size_t count = 1024;
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> pos(-1.0f, 1.0f);
+	std::vector<float> min_x(count), min_y(count), max_x(count), max_y(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		min_x[i] = pos(rng);
+		min_y[i] = pos(rng);
+		max_x[i] = min_x[i] + 0.08f;
+		max_y[i] = min_y[i] + 0.08f;
+	}
+	AabbBatch batch = { min_x.data(), min_y.data(), max_x.data(), max_y.data(), count };
+	Aabb query = { -0.1f, -0.1f, 0.1f, 0.1f };
+	std::vector<std::uint8_t> out(count);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(kernels[which](query, batch, out.data()));
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_CollisionKernel)->Arg(0)->Arg(1)->Arg(2)->ArgName("scalar_sse2_avx2");
+
+// The whole game tick on the stress level: movement, grid upkeep, collision, spawning
+static void BM_GameTick(benchmark::State& state)
+{
+	Level level;
+	if (!load_level(BENCH_ASSET_DIR "/levels/stress.lvl", nullptr, level))
+	{
+		state.SkipWithError("could not load stress.lvl");
+		return;
+	}
+
+	GameState game;
+	game_init(game, &level);
+	InputQueue inputs;
+	for (int t = 0; t < 1000; ++t)
+	{
+		game_step(game, inputs, TICK_DT); // Past the opening, once the field is busy
+	}
+
+	for (auto _ : state)
+	{
+		game_step(game, inputs, TICK_DT);
+	}
+	state.counters["entities"] = static_cast<double>(game.entities.size());
+}
+BENCHMARK(BM_GameTick)->Unit(benchmark::kMicrosecond);
+
+static void BM_ParticleUpdate(benchmark::State& state)
+{
+	const ParticleKernel kernel = state.range(0) ? PARTICLE_KERNEL_SSE2 : PARTICLE_KERNEL_SCALAR;
+	const size_t count = 100000;
+
+	ParticleSystem particles;
+	particles.init(count);
+	std::mt19937 rng(99);
+	std::uniform_real_distribution<float> pos(-0.9f, 0.9f);
+	while (particles.size() < count)
+	{
+		particles.emit(PARTICLE_SPARK, pos(rng), pos(rng), EXPLOSION_SPARKS, 0.0f, 0.0f, 0.5f, 60000);
+	}
+
+	for (auto _ : state)
+	{
+		particles.update(kernel);
+	}
+	state.SetItemsProcessed(state.iterations() * particles.size());
+}
+BENCHMARK(BM_ParticleUpdate)->Arg(0)->Arg(1)->ArgName("sse2")->Unit(benchmark::kMicrosecond);
+
+//=================================================================================================
+// BATCH BUILDING
+//=================================================================================================
+
+static void BM_BuildEntityInstances(benchmark::State& state)
+{
+	StressScene scene;
+	scene.init(static_cast<size_t>(state.range(0)), 1234);
+	std::vector<SpriteInstance> instances(scene.size());
+
+	for (auto _ : state)
+	{
+		build_entity_instances(scene.entities, 0.5f, instances.data(), nullptr);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BuildEntityInstances)->Arg(10000)->Arg(100000);
+
+// Six vertices per quad into a batch that never has to flush
+static void BM_SpriteBatchFill(benchmark::State& state)
+{
+	const size_t quads = static_cast<size_t>(state.range(0));
+	SpriteBatch batch;
+	batch.init(quads * 6); // No context: only the CPU side
+
+	for (auto _ : state)
+	{
+		batch.begin();
+		for (size_t i = 0; i < quads; ++i)
+		{
+			float x = (i % 256) * (2.0f / 256) - 1.0f;
+			batch.add_quad(x, x, 0.01f, 0.01f, { 255, 255, 255, 255 });
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * quads);
+}
+BENCHMARK(BM_SpriteBatchFill)->Arg(1000)->Arg(10000);
+
+// A two-line HUD into the batch, either unchanged since the last frame (the cached quads are
+// copied) or different every frame (laid out again first)
+static void BM_HudText(benchmark::State& state)
+{
+	const bool changing = state.range(0) != 0;
+	BitmapFont font;
+	font.init(); // No context: the texture is never uploaded
+	TextRun run;
+	run.init(&font, 64);
+	SpriteBatch batch;
+	batch.init(4096);
+
+	char text[64];
+	unsigned score = 0;
+	for (auto _ : state)
+	{
+		std::snprintf(text, sizeof(text), "SCORE %u\nHITS %d", changing ? score++ : score, 3);
+		run.set(text, -0.98f, 0.98f, 0.005f, 0.0067f, { 255, 255, 255, 220 });
+		batch.begin();
+		run.draw(batch);
+		benchmark::ClobberMemory();
+	}
+	state.counters["rebuilds"] = static_cast<double>(run.rebuilds());
+}
+BENCHMARK(BM_HudText)->Arg(0)->Arg(1)->ArgName("changing");
+
+//=================================================================================================
+// RENDER SUBMISSION
+//=================================================================================================
+
+#ifdef BENCH_HAS_EGL
+
+// One context for every render benchmark, created on first use
+static HeadlessGl* render_context()
+{
+	static HeadlessGl context;
+	static bool tried = false;
+	if (!tried)
+	{
+		tried = true;
+		context.create(800, 600);
+	}
+	return context.valid() ? &context : nullptr;
+}
+
+// A stress scene frame as display_func draws it: build the instances, one upload, one instanced
+// draw, then wait for the rasterizer so the GPU work is part of the time
+static void BM_RenderSubmit(benchmark::State& state)
+{
+	HeadlessGl* context = render_context();
+	if (!context)
+	{
+		state.SkipWithError("no headless GL context");
+		return;
+	}
+
+	Renderer renderer;
+	renderer.init(RENDER_CORE);
+	if (renderer.path() != RENDER_CORE)
+	{
+		state.SkipWithError("GL 3.3 core path unavailable");
+		return;
+	}
+
+	const size_t count = static_cast<size_t>(state.range(0));
+	SpriteBatch batch;
+	batch.init(65536, &renderer.shaders());
+	InstancedBatch instances;
+	instances.init(SHAPE_QUAD, count, &renderer.shaders(), &batch);
+
+	StressScene scene;
+	scene.init(count, 1234);
+
+	FrameUniforms uniforms;
+	matrix_identity(uniforms.view_proj);
+	uniforms.time[0] = uniforms.time[1] = uniforms.time[2] = uniforms.time[3] = 0.0f;
+
+	for (auto _ : state)
+	{
+		glClear(GL_COLOR_BUFFER_BIT);
+		renderer.begin_frame(uniforms);
+		batch.begin();
+		instances.begin();
+		build_entity_instances(scene.entities, 0.5f, instances.reserve(count), nullptr);
+		instances.flush();
+		batch.flush();
+		glFinish();
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+	state.SetLabel(context->renderer());
+
+	instances.shutdown();
+	batch.shutdown();
+	renderer.shutdown();
+}
+BENCHMARK(BM_RenderSubmit)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// The same frame drawn into a framebuffer object at a fixed resolution, as --offscreen does, so
+// fill rate shows up separately from the window size
+static void BM_OffscreenFrame(benchmark::State& state)
+{
+	HeadlessGl* context = render_context();
+	if (!context)
+	{
+		state.SkipWithError("no headless GL context");
+		return;
+	}
+
+	Renderer renderer;
+	renderer.init(RENDER_CORE);
+	OffscreenTarget target;
+	if (renderer.path() != RENDER_CORE || !target.init(static_cast<int>(state.range(0)), static_cast<int>(state.range(1))))
+	{
+		state.SkipWithError("framebuffer objects unavailable");
+		return;
+	}
+
+	const size_t count = 10000;
+	SpriteBatch batch;
+	batch.init(65536, &renderer.shaders());
+	InstancedBatch instances;
+	instances.init(SHAPE_QUAD, count, &renderer.shaders(), &batch);
+
+	StressScene scene;
+	scene.init(count, 1234);
+
+	FrameUniforms uniforms;
+	matrix_identity(uniforms.view_proj);
+	uniforms.time[0] = uniforms.time[1] = uniforms.time[2] = uniforms.time[3] = 0.0f;
+
+	target.bind();
+	for (auto _ : state)
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		renderer.begin_frame(uniforms);
+		batch.begin();
+		instances.begin();
+		build_entity_instances(scene.entities, 0.5f, instances.reserve(count), nullptr);
+		instances.flush();
+		batch.flush();
+		glFinish();
+	}
+	target.unbind();
+	state.counters["frames_per_second"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+	state.SetLabel(context->renderer());
+
+	instances.shutdown();
+	batch.shutdown();
+	target.shutdown();
+	renderer.shutdown();
+}
+BENCHMARK(BM_OffscreenFrame)->Args({ 1280, 720 })->Args({ 1920, 1080 })->Unit(benchmark::kMillisecond);
+
+#endif
+
+BENCHMARK_MAIN();
@@ -0,0 +1,113 @@
+#include "headless_gl.h"
+#include "gl_ext.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static void* egl_loader(const char* name)
+{
+	return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
+
+// Prefers the surfaceless platform, which needs neither X nor a GPU
+static EGLDisplay open_display()
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+		reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (get_platform_display)
+	{
+		EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display != EGL_NO_DISPLAY)
+		{
+			return display;
+		}
+	}
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool HeadlessGl::create(int width, int height)
+{
+	destroy();
+
+	EGLDisplay egl_display = open_display();
+	EGLint major, minor;
+	if (egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, &major, &minor))
+	{
+		return false;
+	}
+	display = egl_display;
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configs = 0;
+	if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(egl_display, config_attribs, &config, 1, &configs) || configs == 0)
+	{
+		destroy();
+		return false;
+	}
+
+	const EGLint surface_attribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+	EGLSurface egl_surface = eglCreatePbufferSurface(egl_display, config, surface_attribs);
+	if (egl_surface == EGL_NO_SURFACE)
+	{
+		destroy();
+		return false;
+	}
+	surface = egl_surface;
+
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attribs);
+	if (egl_context == EGL_NO_CONTEXT)
+	{
+		destroy();
+		return false;
+	}
+	context = egl_context;
+
+	if (!eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context))
+	{
+		destroy();
+		return false;
+	}
+
+	gl_ext_load(egl_loader);
+	glViewport(0, 0, width, height);
+	return true;
+}
+
+void HeadlessGl::destroy()
+{
+	if (!display)
+	{
+		return;
+	}
+
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (context)
+	{
+		eglDestroyContext(display, context);
+		context = nullptr;
+	}
+	if (surface)
+	{
+		eglDestroySurface(display, surface);
+		surface = nullptr;
+	}
+	eglTerminate(display);
+	display = nullptr;
+}
+
+const char* HeadlessGl::renderer() const
+{
+	return context ? reinterpret_cast<const char*>(glGetString(GL_RENDERER)) : "none";
+}
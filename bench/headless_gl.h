@@ -0,0 +1,30 @@
+#pragma once
+
+//=================================================================================================
+// HEADLESS GL
+//
+// A GL 3.3 core context with an offscreen pbuffer as its framebuffer, created through EGL so no
+// window system (or GLUT) is involved. On Mesa the surfaceless platform falls back to llvmpipe
+// when there is no GPU, so render benchmarks run on build machines too.
+//=================================================================================================
+
+class HeadlessGl
+{
+public:
+	HeadlessGl() = default;
+	HeadlessGl(const HeadlessGl&) = delete;
+	HeadlessGl& operator=(const HeadlessGl&) = delete;
+	~HeadlessGl() { destroy(); }
+
+	// Creates the context, makes it current and loads the GL entry points through EGL
+	bool create(int width, int height);
+	void destroy();
+
+	bool valid() const { return context != nullptr; }
+	const char* renderer() const;
+
+private:
+	void* display = nullptr;
+	void* surface = nullptr;
+	void* context = nullptr;
+};
@@ -0,0 +1,163 @@
+// Checks the SSE2 and AVX2 collision kernels against the scalar one, bit for bit, on the cases
+// SIMD code tends to get wrong: boxes that only touch, NaN coordinates and batch sizes that leave
+// a scalar tail. Exits non-zero on the first disagreement.
+
+#include "collision_kernel.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+typedef size_t (*Kernel)(const Aabb&, const AabbBatch&, std::uint8_t*);
+
+struct Path
+{
+	const char* name;
+	Kernel fn;
+	bool available;
+};
+
+static int Failures = 0;
+
+struct Boxes
+{
+	std::vector<float> min_x, min_y, max_x, max_y;
+
+	void add(float x0, float y0, float x1, float y1)
+	{
+		min_x.push_back(x0);
+		min_y.push_back(y0);
+		max_x.push_back(x1);
+		max_y.push_back(y1);
+	}
+
+	AabbBatch batch() const { return { min_x.data(), min_y.data(), max_x.data(), max_y.data(), min_x.size() }; }
+};
+
+// Runs every available kernel on the same input and compares each against scalar
+static void check(const char* name, const Aabb& query, const Boxes& boxes, const Path* paths, size_t path_count)
+{
+	const AabbBatch batch = boxes.batch();
+	std::vector<std::uint8_t> reference(batch.count + 1, 0xAA);
+	size_t reference_hits = overlap_aabb_scalar(query, batch, reference.data());
+
+	for (size_t p = 0; p < path_count; ++p)
+	{
+		if (!paths[p].available)
+		{
+			continue;
+		}
+
+		std::vector<std::uint8_t> out(batch.count + 1, 0xAA); // The extra byte catches writes past the end
+		size_t hits = paths[p].fn(query, batch, out.data());
+		if (hits != reference_hits || out != reference)
+		{
+			std::printf("FAIL %s: %s gives %zu hits, scalar %zu\n", name, paths[p].name, hits, reference_hits);
+			Failures++;
+		}
+	}
+}
+
+// Scalar on its own, against what the header promises
+static void expect(const char* name, const Aabb& query, const Boxes& boxes, size_t expected_hits)
+{
+	std::vector<std::uint8_t> out(boxes.min_x.size());
+	size_t hits = overlap_aabb_scalar(query, boxes.batch(), out.data());
+	if (hits != expected_hits)
+	{
+		std::printf("FAIL %s: scalar gives %zu hits, expected %zu\n", name, hits, expected_hits);
+		Failures++;
+	}
+}
+
+int main()
+{
+	const Path paths[] = {
+		{ "sse2", overlap_aabb_sse, cpu_has_sse2() },
+		{ "avx2", overlap_aabb_avx2, cpu_has_avx2() },
+	};
+	const size_t path_count = sizeof(paths) / sizeof(paths[0]);
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const Aabb unit = { 0.0f, 0.0f, 1.0f, 1.0f };
+
+	// Touching on an edge or a corner counts, a hair further away does not
+	Boxes touching;
+	touching.add(1.0f, 0.0f, 2.0f, 1.0f); // Right edge
+	touching.add(-1.0f, 0.0f, 0.0f, 1.0f); // Left edge
+	touching.add(0.0f, 1.0f, 1.0f, 2.0f); // Top edge
+	touching.add(0.0f, -1.0f, 1.0f, 0.0f); // Bottom edge
+	touching.add(1.0f, 1.0f, 2.0f, 2.0f); // Corner
+	touching.add(std::nextafter(1.0f, 2.0f), 0.0f, 2.0f, 1.0f); // Just past the right edge
+	touching.add(0.0f, -1.0f, 1.0f, std::nextafter(0.0f, -1.0f)); // Just below the bottom edge
+	touching.add(0.5f, 0.5f, 0.5f, 0.5f); // Degenerate point inside
+	touching.add(-5.0f, -5.0f, 5.0f, 5.0f); // Contains the query
+	expect("touching edges", unit, touching, 7);
+	check("touching edges", unit, touching, paths, path_count);
+
+	// A NaN in any coordinate fails its compare, so the box never overlaps
+	Boxes nans;
+	for (int field = 0; field < 4; ++field)
+	{
+		float c[4] = { 0.25f, 0.25f, 0.75f, 0.75f };
+		c[field] = nan;
+		nans.add(c[0], c[1], c[2], c[3]);
+	}
+	nans.add(0.25f, 0.25f, 0.75f, 0.75f);
+	expect("nan candidates", unit, nans, 1);
+	check("nan candidates", unit, nans, paths, path_count);
+
+	for (int field = 0; field < 4; ++field)
+	{
+		Aabb query = unit;
+		float* c[4] = { &query.min_x, &query.min_y, &query.max_x, &query.max_y };
+		*c[field] = nan;
+		expect("nan query", query, nans, 0);
+		check("nan query", query, nans, paths, path_count);
+	}
+
+	// Every count up to a few AVX2 registers, so each tail length runs on every path, with boxes
+	// snapped to a coarse grid so many of them touch the query exactly and some carry a NaN
+	std::mt19937 rng(2024);
+	std::uniform_int_distribution<int> cell(-8, 8);
+	std::uniform_int_distribution<int> roll(0, 15);
+	for (size_t count = 0; count <= 35; ++count)
+	{
+		for (int round = 0; round < 50; ++round)
+		{
+			Boxes boxes;
+			for (size_t i = 0; i < count; ++i)
+			{
+				float x = cell(rng) * 0.25f;
+				float y = cell(rng) * 0.25f;
+				boxes.add(x, y, x + 0.25f * (1 + roll(rng) % 4), y + 0.25f * (1 + roll(rng) % 4));
+				if (roll(rng) == 0)
+				{
+					float* fields[4] = { &boxes.min_x.back(), &boxes.min_y.back(), &boxes.max_x.back(), &boxes.max_y.back() };
+					*fields[roll(rng) % 4] = nan;
+				}
+			}
+
+			float qx = cell(rng) * 0.25f;
+			float qy = cell(rng) * 0.25f;
+			Aabb query = { qx, qy, qx + 0.5f, qy + 0.5f };
+			char name[64];
+			std::snprintf(name, sizeof(name), "random, %zu boxes", count);
+			check(name, query, boxes, paths, path_count);
+		}
+	}
+
+	for (const Path& path : paths)
+	{
+		std::printf("%-5s %s\n", path.name, path.available ? "checked against scalar" : "not supported on this CPU, skipped");
+	}
+	if (Failures > 0)
+	{
+		std::printf("%d failures\n", Failures);
+		return EXIT_FAILURE;
+	}
+	std::printf("All collision kernel checks passed\n");
+	return EXIT_SUCCESS;
+}